@@ -1,4 +1,4 @@
-QT += widgets serialport charts
+QT += widgets serialport charts svg
 QT += datavisualization
 
 
@@ -11,13 +11,62 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    batchrender.cpp \
+    capturefile.cpp \
+    captureformat.cpp \
+    capturewriter.cpp \
+    chartrenderer.cpp \
+    dataexporter.cpp \
+    decimationpyramid.cpp \
+    devicesimulator.cpp \
+    fake3dchart.cpp \
+    frequencyvisualizer.cpp \
+    heatmapfeeder.cpp \
+    histogram2d.cpp \
+    latencyhistogram.cpp \
     main.cpp \
     mainwindow.cpp \
-    portdialog.cpp
+    portdialog.cpp \
+    renderscheduler.cpp \
+    rollingminmax.cpp \
+    sampledecoder.cpp \
+    samplebuffer.cpp \
+    serialreader.cpp \
+    serialsettings.cpp \
+    simulatordialog.cpp \
+    textimporter.cpp \
+    tracing.cpp \
+    traceplotwidget.cpp
 
 HEADERS += \
+    batchrender.h \
+    capturefile.h \
+    captureformat.h \
+    capturewriter.h \
+    channeltrace.h \
+    chartrenderer.h \
+    dataexporter.h \
+    decimationpyramid.h \
+    devicesimulator.h \
+    fake3dchart.h \
+    frequencyvisualizer.h \
+    heatmapfeeder.h \
+    histogram2d.h \
+    latencyhistogram.h \
     mainwindow.h \
-    portdialog.h
+    portdialog.h \
+    portsession.h \
+    renderscheduler.h \
+    rollingminmax.h \
+    sampledecoder.h \
+    samplebuffer.h \
+    samplering.h \
+    serialreader.h \
+    serialsettings.h \
+    simulatordialog.h \
+    textimporter.h \
+    tracing.h \
+    traceplotwidget.h
 
 FORMS += \
     mainwindow.ui \
@@ -0,0 +1,223 @@
+#include "batchrender.h"
+#include "capturefile.h"
+#include "chartrenderer.h"
+#include "textimporter.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThreadPool>
+#include <cstdio>
+#include <cstring>
+
+// Raw values kept per text column; longer ranges are drawn from the pyramid
+static const qsizetype RawTail = 1 << 20;
+
+namespace {
+
+struct RenderOptions {
+    QString format;
+    QSize size;
+    int dpi = 96;
+    qint64 from = 0;
+    qint64 to = -1;           // -1: end of file
+    int importThreads = 1;
+};
+
+struct RenderJob {
+    QString input;
+    QString output;
+    QString error;
+    bool ok = false;
+};
+
+}
+
+bool isBatchRenderInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--render") == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool capturePage(const QString &fileName, const RenderOptions &options, int pixels,
+                        ChartPage &page, QString *error) {
+    CaptureFile capture;
+    if (!capture.open(fileName)) {
+        *error = capture.errorString();
+        return false;
+    }
+    while (capture.indexMore(4096)) {}
+
+    qint64 end = 0;
+    for (const CaptureFile::Channel &channel : capture.channels())
+        end = qMax(end, channel.sampleCount());
+    page.xMin = options.from;
+    page.xMax = options.to < 0 ? end : options.to;
+
+    for (size_t i = 0; i < capture.channels().size(); ++i) {
+        ChartPage::Trace trace{capture.channels()[i].name, ChartRenderer::traceColor(int(i)), {}};
+        capture.query(int(i), options.from, qint64(page.xMax), pixels, trace.points);
+        page.traces.push_back(std::move(trace));
+    }
+    return true;
+}
+
+static bool textLogPage(const QString &fileName, const RenderOptions &options, int pixels,
+                        ChartPage &page, QString *error) {
+    TextImporter importer(fileName, RawTail);
+    importer.setThreadCount(options.importThreads);
+    if (!importer.importNow()) {
+        *error = importer.errorString();
+        return false;
+    }
+
+    const qint64 first = options.from;
+    const qint64 last = options.to < 0 ? importer.rowCount() : options.to;
+    page.xMin = first;
+    page.xMax = last;
+
+    const QString name = QFileInfo(fileName).fileName();
+    for (size_t c = 0; c < importer.columns().size(); ++c) {
+        const TextImporter::Column &column = importer.columns()[c];
+        ChartPage::Trace trace{QString("%1 ch %2").arg(name).arg(c), ChartRenderer::traceColor(int(c)), {}};
+
+        // Same choice as the Data View: raw values when dense enough, else the pyramid
+        const qint64 end = qMin(last, column.count);
+        const qint64 tailFirst = column.count - qint64(column.tail.size());
+        const int level = column.decimation.chooseLevel(last - first, pixels);
+        if (end > first && level < 0 && first >= tailFirst) {
+            for (qint64 i = first; i < end; ++i)
+                trace.points.append(QPointF(i, column.tail[size_t(i - tailFirst)]));
+        } else if (end > first) {
+            column.decimation.query(first, end, qMax(0, level), trace.points);
+        }
+        page.traces.push_back(std::move(trace));
+    }
+    return true;
+}
+
+static void renderFile(RenderJob &job, const RenderOptions &options) {
+    // PDF pages are A4 landscape at the requested resolution
+    const int pixels = options.format == "pdf" ? qRound(297 / 25.4 * options.dpi) : options.size.width();
+
+    ChartPage page;
+    page.title = QFileInfo(job.input).fileName();
+    page.xLabel = "Samples";
+    const bool isCapture = QFileInfo(job.input).suffix().compare("cdx", Qt::CaseInsensitive) == 0;
+    const bool built = isCapture ? capturePage(job.input, options, pixels, page, &job.error)
+                                 : textLogPage(job.input, options, pixels, page, &job.error);
+    if (!built)
+        return;
+    page.fitY();
+
+    std::vector<ChartPage> pages;
+    pages.push_back(std::move(page));
+    ChartExporter exporter(job.output, options.size, options.dpi, std::move(pages));
+    job.ok = exporter.write();
+    if (!job.ok)
+        job.error = exporter.errorString();
+}
+
+int runBatchRender(int argc, char *argv[]) {
+    // Rendering needs fonts but no display; an explicit platform still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setOrganizationName("SerialDataVisualizer");
+    QGuiApplication::setApplicationName("MenuBar");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders captures (.cdx) or text logs to chart files without a window.");
+    parser.addHelpOption();
+    const QCommandLineOption renderOption("render", "Run in batch render mode.");
+    const QCommandLineOption outputOption({ "o", "output-dir" }, "Directory for the rendered files.", "dir", ".");
+    const QCommandLineOption formatOption("format", "Output format: png, pdf or svg.", "format", "png");
+    const QCommandLineOption sizeOption("size", "Image size in pixels (png, svg).", "WxH", "1920x1080");
+    const QCommandLineOption dpiOption("dpi", "Output resolution.", "dpi", "96");
+    const QCommandLineOption fromOption("from", "First sample to draw, counted per channel (not a time).",
+                                        "sample", "0");
+    const QCommandLineOption toOption("to", "Sample to stop at (default: end of file).", "sample");
+    const QCommandLineOption jobsOption({ "j", "jobs" }, "Files rendered in parallel.", "count",
+                                        QString::number(QThread::idealThreadCount()));
+    parser.addOptions({ renderOption, outputOption, formatOption, sizeOption, dpiOption,
+                        fromOption, toOption, jobsOption });
+    parser.addPositionalArgument("files", "Captures or text logs to render.", "FILE...");
+
+    // Errors go to stderr; process() could show a message box on some platforms
+    if (!parser.parse(app.arguments())) {
+        std::fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 2;
+    }
+    if (parser.isSet("help")) {
+        std::fputs(qPrintable(parser.helpText()), stdout);
+        return 0;
+    }
+
+    RenderOptions options;
+    options.format = parser.value(formatOption).toLower();
+    const QRegularExpressionMatch size = QRegularExpression("^(\\d+)x(\\d+)$").match(parser.value(sizeOption));
+    options.size = size.hasMatch() ? QSize(size.captured(1).toInt(), size.captured(2).toInt()) : QSize();
+    options.dpi = parser.value(dpiOption).toInt();
+    options.from = qMax<qint64>(0, parser.value(fromOption).toLongLong());
+    options.to = parser.isSet(toOption) ? parser.value(toOption).toLongLong() : -1;
+    const int jobs = qMax(1, parser.value(jobsOption).toInt());
+
+    if (!QStringList{ "png", "pdf", "svg" }.contains(options.format) || options.size.isEmpty()
+        || options.dpi <= 0 || (options.to >= 0 && options.to <= options.from)) {
+        std::fprintf(stderr, "Invalid --format, --size, --dpi or range.\n");
+        return 2;
+    }
+    if (parser.positionalArguments().isEmpty()) {
+        std::fprintf(stderr, "No input files.\n");
+        return 2;
+    }
+
+    const QDir outputDir(parser.value(outputOption));
+    if (!outputDir.exists() && !QDir().mkpath(outputDir.path())) {
+        std::fprintf(stderr, "Cannot create %s\n", qPrintable(outputDir.path()));
+        return 1;
+    }
+
+    // Inputs sharing a base name (a/run.cdx, b/run.csv) would render to the
+    // same file at once; later ones get a numbered name instead
+    std::vector<RenderJob> renderJobs;
+    QSet<QString> taken;
+    for (const QString &input : parser.positionalArguments()) {
+        RenderJob job;
+        job.input = input;
+        const QString baseName = QFileInfo(input).completeBaseName();
+        QString name = baseName + "." + options.format;
+        for (int n = 1; taken.contains(name.toLower()); ++n)
+            name = QString("%1-%2.%3").arg(baseName).arg(n).arg(options.format);
+        taken.insert(name.toLower());
+        job.output = outputDir.filePath(name);
+        if (name != baseName + "." + options.format)
+            std::fprintf(stderr, "%s: renders to %s, another input has the same name\n", qPrintable(input),
+                         qPrintable(job.output));
+        renderJobs.push_back(job);
+    }
+
+    // One file per pool thread; the cores left over go to each text import
+    const int parallel = qMin(jobs, int(renderJobs.size()));
+    options.importThreads = qMax(1, QThread::idealThreadCount() / parallel);
+    QThreadPool pool;
+    pool.setMaxThreadCount(parallel);
+    for (RenderJob &job : renderJobs)
+        pool.start([&job, &options]() { renderFile(job, options); });
+    pool.waitForDone();
+
+    int failed = 0;
+    for (const RenderJob &job : renderJobs) {
+        if (job.ok) {
+            std::printf("%s -> %s\n", qPrintable(job.input), qPrintable(job.output));
+        } else {
+            std::fprintf(stderr, "%s: %s\n", qPrintable(job.input), qPrintable(job.error));
+            ++failed;
+        }
+    }
+    return failed ? 1 : 0;
+}
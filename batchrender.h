@@ -0,0 +1,18 @@
+#ifndef BATCHRENDER_H
+#define BATCHRENDER_H
+
+// Headless batch mode: renders captures (.cdx) or text logs to chart files
+// without creating any widgets, e.g. for nightly reports on a server.
+//
+//   MenuBar --render [-o DIR] [--format png|pdf|svg] [--size WxH] [--dpi N]
+//           [--from SAMPLE] [--to SAMPLE] [-j JOBS] FILE...
+//
+// The range counts samples per channel, as the Data View's X axis does;
+// text logs carry no timestamps to convert it to time.
+//
+// Files are rendered in parallel, one per job. QT_QPA_PLATFORM defaults to
+// offscreen, so no display is needed.
+bool isBatchRenderInvocation(int argc, char *argv[]);
+int runBatchRender(int argc, char *argv[]);
+
+#endif // BATCHRENDER_H
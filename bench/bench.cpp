@@ -0,0 +1,331 @@
+// Benchmarks for the ingest, parse, render and export stages. Results go to
+// stderr as a table and to stdout (or --json FILE) as JSON, so runs can be
+// compared between releases:
+//
+//   menubar-bench [--json FILE] [--filter TEXT] [--min-time SECONDS]
+//
+// QT_QPA_PLATFORM defaults to offscreen, so no display is needed.
+#include "chartrenderer.h"
+#include "devicesimulator.h"
+#include "fake3dchart.h"
+#include "frequencyvisualizer.h"
+#include "rollingminmax.h"
+#include "sampledecoder.h"
+#include "samplering.h"
+#include <QApplication>
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Keeps benchmarked results observable so they are not optimised away
+volatile double sink;
+
+class Runner {
+public:
+    Runner(const QString &filter, double minSeconds)
+        : filter(filter), minNs(qint64(minSeconds * 1e9)) {}
+
+    // Runs `iteration` (which handles `items` items) until minNs has passed
+    template <typename F>
+    void run(const QString &name, qint64 items, F &&iteration) {
+        if (!filter.isEmpty() && !name.contains(filter))
+            return;
+
+        iteration();   // warm-up: caches, lazy allocations
+        QElapsedTimer timer;
+        timer.start();
+        qint64 iterations = 0;
+        do {
+            iteration();
+            ++iterations;
+        } while (timer.nsecsElapsed() < minNs);
+
+        const double ns = double(timer.nsecsElapsed()) / double(iterations);
+        QJsonObject result;
+        result["name"] = name;
+        result["iterations"] = iterations;
+        result["ns_per_iteration"] = ns;
+        result["items_per_iteration"] = items;
+        result["items_per_second"] = double(items) * 1e9 / ns;
+        results.append(result);
+        std::fprintf(stderr, "%-44s %14.0f ns/iter %16.0f items/s\n", qPrintable(name), ns,
+                     double(items) * 1e9 / ns);
+    }
+
+    QJsonArray results;
+
+private:
+    QString filter;
+    qint64 minNs;
+};
+
+QByteArray generateStream(SampleDecoder::Kind framing, int channels, qint64 samples) {
+    SimulatorSettings settings;
+    settings.framing = framing;
+    settings.channels = channels;
+    settings.noise = 1;
+    SignalGenerator generator(settings);
+
+    QByteArray stream(qsizetype(samples + channels) * 32, Qt::Uninitialized);
+    stream.truncate(generator.generate(stream.data(), stream.size(), samples));
+    return stream;
+}
+
+void benchParse(Runner &runner) {
+    const qint64 lines = 100000;
+    const QByteArray text = generateStream(SampleDecoder::Kind::TextLines, 1, lines);
+    const QByteArray text4 = generateStream(SampleDecoder::Kind::TextLines, 4, lines * 4);
+    const QByteArray binary = generateStream(SampleDecoder::Kind::BinaryFrames, 1, lines);
+
+    // The original per-line path: one QByteArray per line, trimmed, converted
+    runner.run("parse/readline_todouble", lines, [&]() {
+        QBuffer buffer;
+        buffer.setData(text);
+        buffer.open(QIODevice::ReadOnly);
+        double sum = 0;
+        while (buffer.canReadLine())
+            sum += buffer.readLine().trimmed().toDouble();
+        sink = sum;
+    });
+
+    SampleRing<Sample> ring(1 << 19);
+    std::vector<Sample> drained(1 << 19);
+    auto decodeAll = [&](SampleDecoder::Kind kind, const QByteArray &data) {
+        std::unique_ptr<SampleDecoder> decoder = SampleDecoder::create(kind);
+        decoder->decode(data.constData(), data.size(), 0, ring);
+        sink = double(ring.pop(drained.data(), drained.size()));
+    };
+    runner.run("parse/line_decoder", lines, [&]() { decodeAll(SampleDecoder::Kind::TextLines, text); });
+    runner.run("parse/line_decoder_4ch", lines * 4, [&]() { decodeAll(SampleDecoder::Kind::TextLines, text4); });
+    runner.run("parse/binary_decoder", lines, [&]() { decodeAll(SampleDecoder::Kind::BinaryFrames, binary); });
+}
+
+void benchRing(Runner &runner) {
+    const qint64 count = 1 << 20;
+    SampleRing<Sample> ring(1 << 16);
+    std::vector<Sample> out(1024);
+
+    runner.run("ring/push_pop", count, [&]() {
+        Sample sample;
+        for (qint64 i = 0; i < count; i += qint64(out.size())) {
+            for (size_t j = 0; j < out.size(); ++j) {
+                sample.value = double(j);
+                ring.push(sample);
+            }
+            ring.pop(out.data(), out.size());
+        }
+        sink = out.front().value;
+    });
+
+    // Reader thread to GUI thread, as in a session
+    // The producer thread is started once and pushes `count` samples per
+    // round; each iteration releases one round and drains it
+    std::atomic<qint64> rounds{0};
+    std::atomic<bool> done{false};
+    std::thread producer([&ring, &rounds, &done, count]() {
+        Sample sample;
+        qint64 round = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            if (rounds.load(std::memory_order_acquire) == round) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (qint64 i = 0; i < count;) {
+                sample.value = double(i);
+                if (ring.push(sample)) ++i;
+            }
+            ++round;
+        }
+    });
+    runner.run("ring/spsc_threads", count, [&]() {
+        rounds.fetch_add(1, std::memory_order_release);
+        qint64 received = 0;
+        while (received < count)
+            received += qint64(ring.pop(out.data(), out.size()));
+        sink = out.front().value;
+    });
+    done.store(true, std::memory_order_relaxed);
+    producer.join();
+}
+
+void benchYRange(Runner &runner) {
+    std::mt19937 random(1);
+    std::normal_distribution<double> normal(0, 100);
+    std::vector<double> values(1 << 20);
+    for (double &value : values)
+        value = normal(random);
+
+    for (int window : { 100, 10000 }) {
+        RollingMinMax range(window);
+        runner.run(QString("yrange/rolling_minmax/%1").arg(window), qint64(values.size()), [&]() {
+            for (double value : values)
+                range.add(value);
+            sink = range.max() - range.min();
+        });
+    }
+}
+
+void benchPaint(Runner &runner) {
+    QImage target(800, 600, QImage::Format_ARGB32_Premultiplied);
+    std::mt19937 random(1);
+    std::normal_distribution<double> normal(0, 1);
+    std::vector<double> xs(10000), ys(10000);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = normal(random);
+        ys[i] = normal(random);
+    }
+
+    // x values, then y values, within [-0.5, 0.5)
+    std::uniform_real_distribution<double> box(-0.5, 0.5);
+    std::vector<double> local(20000);
+    for (double &value : local)
+        value = box(random);
+
+    for (int bins : { 64, 256, 1024 }) {
+        const QString size = QString("%1x%1").arg(bins);
+
+        Fake3DChart chart;
+        chart.resize(target.size());
+        chart.histogram().setAutoRange(false);
+        chart.histogram().setBins(bins, bins);
+        chart.histogram().setRange(-4, 4, -4, 4);
+        chart.histogramChanged();
+        // Every batch raises the maximum count, so each frame recolours the whole image
+        runner.run("paint/fake3dchart/" + size, qint64(xs.size()), [&]() {
+            chart.addDataPoints(xs.data(), ys.data(), qsizetype(xs.size()));
+            chart.flush();
+            chart.render(&target);
+        });
+
+        // Steady state: a preloaded corner bin keeps the maximum fixed and the
+        // batches stay in a small box, so only that box is recoloured
+        chart.histogram().clear();
+        const double hot = double(1 << 24);
+        std::vector<double> corner(1 << 20, 3.99);
+        for (int i = 0; i < 16; ++i)
+            chart.addDataPoints(corner.data(), corner.data(), qsizetype(corner.size()));
+        runner.run("paint/fake3dchart_steady/" + size, qint64(local.size() / 2), [&]() {
+            chart.addDataPoints(local.data(), local.data() + local.size() / 2, qsizetype(local.size() / 2));
+            chart.flush();
+            chart.render(&target);
+        });
+        if (chart.histogram().maxStoredCount() != hot)
+            std::fprintf(stderr, "paint/fake3dchart_steady/%s: the maximum moved, raise the preload\n",
+                         qPrintable(size));
+
+        std::vector<int> cells(size_t(bins) * size_t(bins));
+        for (int &cell : cells)
+            cell = int(random() % 1000);
+        FrequencyVisualizer grid;
+        grid.resize(target.size());
+        grid.setData(cells.data(), bins, bins);
+
+        // One row changes per frame, then the whole grid
+        std::vector<int> row(size_t(bins), 0);
+        int next = 0;
+        runner.run("paint/frequencyvisualizer_row/" + size, bins, [&]() {
+            for (int &cell : row)
+                cell = int(random() % 1000);
+            grid.updateCells(next++ % bins, 0, 1, bins, row.data(), bins);
+            grid.render(&target);
+        });
+        runner.run("paint/frequencyvisualizer_grid/" + size, qint64(cells.size()), [&]() {
+            grid.setData(cells.data(), bins, bins);
+            grid.render(&target);
+        });
+    }
+}
+
+void benchExport(Runner &runner) {
+    // Two points per pixel column at 1080p, as the exporters build them
+    ChartPage page;
+    page.title = "Benchmark";
+    page.xMax = 1920;
+    std::mt19937 random(1);
+    std::normal_distribution<double> normal(0, 1);
+    for (int t = 0; t < 4; ++t) {
+        ChartPage::Trace trace;
+        trace.name = QString("Trace %1").arg(t);
+        trace.color = ChartRenderer::traceColor(t);
+        double value = 0;
+        for (int x = 0; x < 1920; ++x) {
+            value += normal(random);
+            trace.points.append(QPointF(x, value - 1));
+            trace.points.append(QPointF(x, value + 1));
+        }
+        page.traces.push_back(trace);
+    }
+    page.fitY();
+    const qint64 points = 4 * 1920 * 2;
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    runner.run("render/chart_1080p", points, [&]() {
+        QPainter painter(&image);
+        ChartRenderer::render(painter, image.rect(), page);
+    });
+
+    QTemporaryDir dir;
+    for (const char *suffix : { "png", "pdf", "svg" }) {
+        const QString fileName = dir.filePath(QString("chart.") + suffix);
+        runner.run(QString("export/chart_%1").arg(suffix), points, [&]() {
+            ChartExporter exporter(fileName, QSize(1920, 1080), 300, { page });
+            if (!exporter.write())
+                std::fprintf(stderr, "%s\n", qPrintable(exporter.errorString()));
+        });
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the ingest, parse, render and export stages.");
+    parser.addHelpOption();
+    const QCommandLineOption jsonOption("json", "Write the results to a file instead of stdout.", "file");
+    const QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains the text.", "text");
+    const QCommandLineOption minTimeOption("min-time", "Seconds each benchmark runs at least.", "seconds", "0.5");
+    parser.addOptions({ jsonOption, filterOption, minTimeOption });
+    parser.process(app);
+
+    Runner runner(parser.value(filterOption), parser.value(minTimeOption).toDouble());
+    benchParse(runner);
+    benchRing(runner);
+    benchYRange(runner);
+    benchPaint(runner);
+    benchExport(runner);
+
+    QJsonObject report;
+    report["qt_version"] = QString(qVersion());
+    report["platform"] = QGuiApplication::platformName();
+    report["threads"] = QThread::idealThreadCount();
+    report["results"] = runner.results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (!parser.isSet(jsonOption)) {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        return 0;
+    }
+    QFile file(parser.value(jsonOption));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        std::fprintf(stderr, "%s\n", qPrintable(file.errorString()));
+        return 1;
+    }
+    return 0;
+}
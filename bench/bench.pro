@@ -0,0 +1,31 @@
+QT += widgets charts svg
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Benchmarks for the ingest, parse, render and export stages. Build and run:
+#   qmake bench/bench.pro && make && ./menubar-bench --json results.json
+TARGET = menubar-bench
+INCLUDEPATH += ..
+
+SOURCES += \
+    bench.cpp \
+    ../chartrenderer.cpp \
+    ../devicesimulator.cpp \
+    ../fake3dchart.cpp \
+    ../frequencyvisualizer.cpp \
+    ../histogram2d.cpp \
+    ../rollingminmax.cpp \
+    ../sampledecoder.cpp \
+    ../tracing.cpp
+
+HEADERS += \
+    ../chartrenderer.h \
+    ../devicesimulator.h \
+    ../fake3dchart.h \
+    ../frequencyvisualizer.h \
+    ../histogram2d.h \
+    ../rollingminmax.h \
+    ../sampledecoder.h \
+    ../samplering.h \
+    ../tracing.h
@@ -0,0 +1,202 @@
+#include "capturefile.h"
+#include <algorithm>
+#include <cstring>
+
+CaptureFile::~CaptureFile() {
+    close();
+}
+
+bool CaptureFile::open(const QString &fileName) {
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorText = file.errorString();
+        return false;
+    }
+
+    mapSize = file.size();
+    if (mapSize < CaptureFormat::HeaderSize) {
+        errorText = "File is too small to be a capture.";
+        close();
+        return false;
+    }
+
+    map = file.map(0, mapSize);
+    if (!map) {
+        errorText = file.errorString();
+        close();
+        return false;
+    }
+
+    header = reinterpret_cast<const CaptureFormat::FileHeader *>(map);
+    if (std::memcmp(header->magic, CaptureFormat::Magic, sizeof(header->magic)) != 0
+        || header->version != CaptureFormat::Version
+        || header->blockSamples != quint32(CaptureFormat::BlockSamples)) {
+        errorText = "Not a supported capture file.";
+        close();
+        return false;
+    }
+
+    const quint32 named = qMin<quint32>(header->channelCount, CaptureFormat::MaxChannels);
+    for (quint32 i = 0; i < named; ++i) {
+        const CaptureFormat::ChannelInfo &info = header->channels[i];
+        namesByKey.insert(info.key, QString::fromUtf8(info.name, int(strnlen(info.name, sizeof(info.name)))));
+    }
+
+    totalBlocks = (mapSize - CaptureFormat::HeaderSize) / CaptureFormat::BlockSize;
+    return true;
+}
+
+void CaptureFile::close() {
+    if (map) {
+        file.unmap(map);
+        map = nullptr;
+    }
+    file.close();
+    header = nullptr;
+    mapSize = 0;
+    totalBlocks = scannedBlocks = 0;
+    channelList.clear();
+    channelByKey.clear();
+    namesByKey.clear();
+}
+
+bool CaptureFile::indexMore(int maxBlocks) {
+    for (int i = 0; i < maxBlocks && scannedBlocks < totalBlocks; ++i) {
+        const qint64 offset = CaptureFormat::HeaderSize + scannedBlocks * CaptureFormat::BlockSize;
+        const auto *block = reinterpret_cast<const CaptureFormat::BlockHeader *>(map + offset);
+        if (block->magic == CaptureFormat::NameMagic && block->count <= quint32(CaptureFormat::NamesPerBlock)) {
+            readNames(block);
+            ++scannedBlocks;
+            continue;
+        }
+        if (block->magic != CaptureFormat::BlockMagic || block->count == 0
+            || block->count > quint32(CaptureFormat::BlockSamples)) {
+            // Truncated or damaged tail, e.g. a recording that was not stopped
+            totalBlocks = scannedBlocks;
+            break;
+        }
+
+        auto it = channelByKey.find(block->key);
+        if (it == channelByKey.end()) {
+            Channel channel;
+            channel.key = block->key;
+            channel.name = namesByKey.value(block->key, QString("Channel %1").arg(block->key));
+            channelList.push_back(std::move(channel));
+            it = channelByKey.insert(block->key, int(channelList.size()) - 1);
+        }
+
+        Channel &channel = channelList[size_t(it.value())];
+        channel.blocks.push_back(BlockInfo{block, block->firstIndex, block->firstIndex + block->count});
+        ++scannedBlocks;
+    }
+    return !isIndexComplete();
+}
+
+void CaptureFile::readNames(const CaptureFormat::BlockHeader *block) {
+    const auto *infos = reinterpret_cast<const CaptureFormat::ChannelInfo *>(
+        reinterpret_cast<const uchar *>(block) + CaptureFormat::BlockHeaderSize);
+    for (quint32 i = 0; i < block->count; ++i) {
+        const CaptureFormat::ChannelInfo &info = infos[i];
+        const QString name = QString::fromUtf8(info.name, int(strnlen(info.name, sizeof(info.name))));
+        namesByKey.insert(info.key, name);
+
+        // Name blocks follow the data, so the channel usually exists already
+        auto it = channelByKey.constFind(info.key);
+        if (it != channelByKey.constEnd())
+            channelList[size_t(it.value())].name = name;
+    }
+}
+
+size_t CaptureFile::findBlock(const Channel &channel, qint64 index) const {
+    // First block whose range ends after index
+    auto it = std::upper_bound(channel.blocks.begin(), channel.blocks.end(), index,
+                               [](qint64 i, const BlockInfo &b) { return i < b.endIndex; });
+    return size_t(it - channel.blocks.begin());
+}
+
+const qint64 *CaptureFile::timestamps(const BlockInfo &block) const {
+    const uchar *base = reinterpret_cast<const uchar *>(block.header) + CaptureFormat::BlockHeaderSize;
+    return reinterpret_cast<const qint64 *>(base);
+}
+
+const double *CaptureFile::values(const BlockInfo &block) const {
+    const uchar *base = reinterpret_cast<const uchar *>(block.header) + CaptureFormat::BlockHeaderSize
+                        + CaptureFormat::BlockSamples * sizeof(qint64);
+    return reinterpret_cast<const double *>(base);
+}
+
+bool CaptureFile::sample(int channel, qint64 index, qint64 *timestampNs, double *value) {
+    if (channel < 0 || channel >= int(channelList.size()))
+        return false;
+
+    const Channel &c = channelList[size_t(channel)];
+    const size_t b = findBlock(c, index);
+    if (b >= c.blocks.size() || index < c.blocks[b].firstIndex)
+        return false;
+
+    const BlockInfo &block = c.blocks[b];
+    if (timestampNs) *timestampNs = timestamps(block)[index - block.firstIndex];
+    if (value) *value = values(block)[index - block.firstIndex];
+    return true;
+}
+
+void CaptureFile::query(int channel, qint64 first, qint64 last, int pixels, QList<QPointF> &out) {
+    if (channel < 0 || channel >= int(channelList.size()))
+        return;
+
+    const Channel &c = channelList[size_t(channel)];
+    first = qMax<qint64>(0, first);
+    last = qMin(last, c.sampleCount());
+    if (first >= last)
+        return;
+
+    const qint64 bucket = qMax<qint64>(1, (last - first) / qMax(1, pixels));
+
+    // Min/max accumulator for the current pixel column
+    qint64 column = -1;
+    double lo = 0, hi = 0;
+    qint64 loX = 0, hiX = 0;
+    auto flush = [&]() {
+        if (column < 0) return;
+        out.append(QPointF(qMin(loX, hiX), loX <= hiX ? lo : hi));
+        if (loX != hiX)
+            out.append(QPointF(qMax(loX, hiX), loX <= hiX ? hi : lo));
+    };
+    auto add = [&](qint64 x, double min, qint64 minX, double max, qint64 maxX) {
+        const qint64 col = (x - first) / bucket;
+        if (col != column) {
+            flush();
+            column = col;
+            lo = min; loX = minX;
+            hi = max; hiX = maxX;
+            return;
+        }
+        if (min < lo) { lo = min; loX = minX; }
+        if (max > hi) { hi = max; hiX = maxX; }
+    };
+
+    for (size_t b = findBlock(c, first); b < c.blocks.size() && c.blocks[b].firstIndex < last; ++b) {
+        const BlockInfo &block = c.blocks[b];
+        const qint64 from = qMax(first, block.firstIndex);
+        const qint64 to = qMin(last, block.endIndex);
+
+        if (bucket >= CaptureFormat::BlockSamples && from == block.firstIndex && to == block.endIndex) {
+            // Whole block inside one column: the header summary is enough
+            const qint64 mid = (block.firstIndex + block.endIndex) / 2;
+            add(block.firstIndex, block.header->min, block.firstIndex, block.header->max, mid);
+            continue;
+        }
+
+        const double *v = values(block);
+        for (qint64 i = from; i < to; ++i) {
+            const double value = v[i - block.firstIndex];
+            if (bucket == 1)
+                out.append(QPointF(i, value));
+            else
+                add(i, value, i, value, i);
+        }
+    }
+    flush();
+}
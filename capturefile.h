@@ -0,0 +1,79 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QString>
+#include <vector>
+
+#include "captureformat.h"
+
+// Read-only view of a recorded capture. The file is memory-mapped and its
+// block index is built lazily from the block headers, so opening a large
+// capture only touches the pages that are actually displayed.
+class CaptureFile {
+public:
+    struct BlockInfo {
+        const CaptureFormat::BlockHeader *header;
+        qint64 firstIndex;
+        qint64 endIndex;
+    };
+
+    struct Channel {
+        quint32 key = 0;
+        QString name;
+        std::vector<BlockInfo> blocks;
+        qint64 sampleCount() const { return blocks.empty() ? 0 : blocks.back().endIndex; }
+    };
+
+    CaptureFile() = default;
+    ~CaptureFile();
+
+    CaptureFile(const CaptureFile &) = delete;
+    CaptureFile &operator=(const CaptureFile &) = delete;
+
+    bool open(const QString &fileName);
+    void close();
+    QString errorString() const { return errorText; }
+    QString fileName() const { return file.fileName(); }
+
+    // Indexes up to maxBlocks more block headers; false once the index is complete
+    bool indexMore(int maxBlocks);
+    bool isIndexComplete() const { return scannedBlocks >= totalBlocks; }
+    int indexProgress() const { return totalBlocks ? int(scannedBlocks * 100 / totalBlocks) : 100; }
+
+    const std::vector<Channel> &channels() const { return channelList; }
+    qint64 startEpochMs() const { return header ? header->startEpochMs : 0; }
+    qint64 startSteadyNs() const { return header ? header->startSteadyNs : 0; }
+
+    // Sample access by channel index. Only blocks indexed so far are seen, so
+    // a lookup never scans the file; indexMore() extends what is visible.
+    bool sample(int channel, qint64 index, qint64 *timestampNs, double *value);
+
+    // Appends [first, last) of a channel to out, reduced to a min/max pair
+    // per pixel column when there are more samples than pixels. Only the
+    // blocks overlapping the range are decoded; when a pixel spans whole
+    // blocks, the block headers' min/max are used without touching samples.
+    void query(int channel, qint64 first, qint64 last, int pixels, QList<QPointF> &out);
+
+private:
+    void readNames(const CaptureFormat::BlockHeader *block);
+    size_t findBlock(const Channel &channel, qint64 index) const;
+    const qint64 *timestamps(const BlockInfo &block) const;
+    const double *values(const BlockInfo &block) const;
+
+    QFile file;
+    uchar *map = nullptr;
+    qint64 mapSize = 0;
+    const CaptureFormat::FileHeader *header = nullptr;
+    qint64 totalBlocks = 0;
+    qint64 scannedBlocks = 0;
+    std::vector<Channel> channelList;
+    QHash<quint32, int> channelByKey;
+    QHash<quint32, QString> namesByKey;
+    QString errorText;
+};
+
+#endif // CAPTUREFILE_H
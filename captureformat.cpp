@@ -0,0 +1,66 @@
+#include "captureformat.h"
+#include <algorithm>
+#include <cstring>
+
+namespace CaptureFormat {
+
+ChannelInfo channelInfo(quint32 key, const QString &name) {
+    ChannelInfo info{};
+    info.key = key;
+    const QByteArray utf8 = name.toUtf8().left(sizeof(info.name) - 1);
+    std::memcpy(info.name, utf8.constData(), size_t(utf8.size()));
+    return info;
+}
+
+void encodeHeader(char *out, qint64 startEpochMs, qint64 startSteadyNs,
+                  const ChannelInfo *channels, size_t channelCount) {
+    FileHeader header{};
+    std::memcpy(header.magic, Magic, sizeof(header.magic));
+    header.version = Version;
+    header.blockSamples = BlockSamples;
+    header.channelCount = quint32(qMin<size_t>(channelCount, MaxChannels));
+    header.startEpochMs = startEpochMs;
+    header.startSteadyNs = startSteadyNs;
+    for (quint32 i = 0; i < header.channelCount; ++i)
+        header.channels[i] = channels[i];
+
+    std::memset(out, 0, HeaderSize);
+    std::memcpy(out, &header, sizeof(header));
+}
+
+void encodeNameBlock(char *out, const ChannelInfo *channels, size_t count) {
+    BlockHeader header{};
+    header.magic = NameMagic;
+    header.count = quint32(count);
+    std::memset(out, 0, BlockSize);
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + BlockHeaderSize, channels, count * sizeof(ChannelInfo));
+}
+
+void encodeBlock(char *out, quint32 key, qint64 firstIndex,
+                 const qint64 *timestamps, const double *values, int count) {
+    BlockHeader header{};
+    header.magic = BlockMagic;
+    header.key = key;
+    header.count = quint32(count);
+    header.firstIndex = firstIndex;
+    header.firstTimestampNs = timestamps[0];
+    header.lastTimestampNs = timestamps[count - 1];
+    header.min = header.max = values[0];
+    for (int i = 1; i < count; ++i) {
+        header.min = qMin(header.min, values[i]);
+        header.max = qMax(header.max, values[i]);
+    }
+    std::memcpy(out, &header, sizeof(header));
+    out += BlockHeaderSize;
+
+    // Unused slots of a partial block are zero
+    const size_t unused = size_t(BlockSamples - count);
+    std::memcpy(out, timestamps, size_t(count) * sizeof(qint64));
+    std::memset(out + count * sizeof(qint64), 0, unused * sizeof(qint64));
+    out += BlockSamples * sizeof(qint64);
+    std::memcpy(out, values, size_t(count) * sizeof(double));
+    std::memset(out + count * sizeof(double), 0, unused * sizeof(double));
+}
+
+}
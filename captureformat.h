@@ -0,0 +1,92 @@
+#ifndef CAPTUREFORMAT_H
+#define CAPTUREFORMAT_H
+
+#include <QString>
+#include <QtGlobal>
+
+// On-disk layout of a recorded capture (.cdx). All fields are little-endian.
+//
+//   FileHeader, padded to HeaderSize bytes
+//   Block 0, Block 1, ...          each exactly BlockSize bytes
+//   Name blocks                    only with more than MaxChannels channels
+//
+// A block holds up to BlockSamples samples of one channel: a BlockHeader
+// (with the block's time span and min/max), then BlockSamples timestamps
+// and BlockSamples values. Unused slots of a partial block are zero. The
+// fixed block stride means a reader can index a file by visiting only the
+// block headers, and the header's channel table is rewritten when
+// recording stops (block headers carry the channel key, so a file that was
+// not closed cleanly can still be read). The header names the first
+// MaxChannels channels; the rest are named by name blocks written after
+// the data, which share the block stride: a BlockHeader with NameMagic and
+// `count` ChannelInfo entries after it.
+namespace CaptureFormat {
+
+constexpr char Magic[8] = { 'C', 'D', 'X', 'C', 'A', 'P', '0', '1' };
+constexpr quint32 Version = 1;
+constexpr quint32 BlockMagic = 0x4B4C4243;   // "CBLK"
+constexpr quint32 NameMagic = 0x4D414E43;    // "CNAM"
+constexpr int BlockSamples = 4096;
+constexpr int MaxChannels = 63;
+constexpr int ChannelsPerDevice = 256;
+constexpr qint64 HeaderSize = 4096;
+
+struct ChannelInfo {
+    quint32 key;          // device * ChannelsPerDevice + channel
+    char name[60];        // UTF-8, NUL terminated
+};
+
+struct FileHeader {
+    char magic[8];
+    quint32 version;
+    quint32 blockSamples;
+    quint32 channelCount;
+    quint32 reserved;
+    qint64 startEpochMs;  // wall clock when recording started
+    qint64 startSteadyNs; // steady clock matching startEpochMs
+    ChannelInfo channels[MaxChannels];
+};
+
+struct BlockHeader {
+    quint32 magic;
+    quint32 key;
+    quint32 count;        // valid samples in this block
+    quint32 reserved;
+    qint64 firstIndex;    // channel sample index of the first sample
+    qint64 firstTimestampNs;
+    qint64 lastTimestampNs;
+    double min;
+    double max;
+    qint64 reserved2;
+};
+
+constexpr qint64 BlockHeaderSize = sizeof(BlockHeader);
+constexpr qint64 BlockSize = BlockHeaderSize + qint64(BlockSamples) * (sizeof(qint64) + sizeof(double));
+
+constexpr int NamesPerBlock = int((BlockSize - BlockHeaderSize) / sizeof(ChannelInfo));
+
+static_assert(sizeof(FileHeader) <= HeaderSize, "capture header does not fit");
+static_assert(sizeof(BlockHeader) == 64, "unexpected block header padding");
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "capture files are written in host byte order");
+
+inline quint32 channelKey(int device, int channel) {
+    return quint32(device) * ChannelsPerDevice + quint32(channel);
+}
+
+ChannelInfo channelInfo(quint32 key, const QString &name);
+
+// Fills out[0, HeaderSize) with a file header listing up to MaxChannels
+// channels; name the rest with encodeNameBlock()
+void encodeHeader(char *out, qint64 startEpochMs, qint64 startSteadyNs,
+                  const ChannelInfo *channels, size_t channelCount);
+
+// Fills out[0, BlockSize) with a name block of `count` (1..NamesPerBlock) channels
+void encodeNameBlock(char *out, const ChannelInfo *channels, size_t count);
+
+// Fills out[0, BlockSize) with one block of `count` (1..BlockSamples) samples
+void encodeBlock(char *out, quint32 key, qint64 firstIndex,
+                 const qint64 *timestamps, const double *values, int count);
+
+}
+
+#endif // CAPTUREFORMAT_H
@@ -0,0 +1,176 @@
+#include "capturewriter.h"
+#include "tracing.h"
+#include <QDateTime>
+
+static const qsizetype WriteBufferSize = 64 * CaptureFormat::BlockSize;   // ~4 MiB
+
+CaptureWriter::CaptureWriter(QObject *parent)
+    : QObject(parent) {}
+
+CaptureWriter::~CaptureWriter() {
+    stop();
+}
+
+bool CaptureWriter::start(const QString &fileName, const QStringList &deviceNames) {
+    stop();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorText = file.errorString();
+        return false;
+    }
+
+    // Created lazily so the timer lives on the writer thread
+    if (!drainTimer) {
+        drainTimer = new QTimer(this);
+        drainTimer->setInterval(20);
+        connect(drainTimer, &QTimer::timeout, this, &CaptureWriter::drain);
+    }
+
+    names = deviceNames;
+    staging.clear();
+    channels.clear();
+    writeBuffer.resize(WriteBufferSize);
+    buffered = 0;
+    startEpochMs = QDateTime::currentMSecsSinceEpoch();
+    startSteadyNs = steadyClockNs();
+    written.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    errorText.clear();
+
+    // Placeholder header; the channel table is filled in by stop()
+    writeHeader();
+    file.seek(CaptureFormat::HeaderSize);
+
+    recording.store(true, std::memory_order_release);
+    drainTimer->start();
+    return true;
+}
+
+void CaptureWriter::stop() {
+    if (!isRecording())
+        return;
+
+    drainTimer->stop();
+    drain();
+    recording.store(false, std::memory_order_release);
+    sources.clear();
+
+    // Partial blocks are written at full size so the block stride stays fixed
+    for (Staging &block : staging) {
+        if (block.count > 0)
+            writeBlock(block);
+    }
+    writeNameBlocks();
+    flushBuffer();
+    writeHeader();
+    file.close();
+}
+
+void CaptureWriter::addSource(int device, SampleRing<Sample> *ring) {
+    removeSource(device);
+    sources.push_back(Source{device, ring, ring->overruns()});
+}
+
+void CaptureWriter::removeSource(int device) {
+    for (auto it = sources.begin(); it != sources.end(); ++it) {
+        if (it->device == device) {
+            if (isRecording())
+                drainSource(*it);
+            sources.erase(it);
+            return;
+        }
+    }
+}
+
+void CaptureWriter::drain() {
+    TraceScope trace("CaptureWriter::drain");
+    for (Source &source : sources)
+        drainSource(source);
+}
+
+void CaptureWriter::drainSource(Source &source) {
+    Sample batch[1024];
+    size_t n;
+    while ((n = source.ring->pop(batch, 1024)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            batch[i].device = quint16(source.device);
+            stage(batch[i]);
+        }
+        written.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    const quint64 overruns = source.ring->overruns();
+    dropped.fetch_add(overruns - source.reportedOverruns, std::memory_order_relaxed);
+    source.reportedOverruns = overruns;
+}
+
+void CaptureWriter::stage(const Sample &sample) {
+    const quint32 key = CaptureFormat::channelKey(sample.device, sample.channel);
+    auto it = staging.find(key);
+    if (it == staging.end()) {
+        Staging block;
+        block.key = key;
+        block.timestamps.resize(CaptureFormat::BlockSamples);
+        block.values.resize(CaptureFormat::BlockSamples);
+        it = staging.insert(key, std::move(block));
+
+        const QString name = QString("%1 ch %2")
+                                 .arg(names.value(sample.device, QString("Device %1").arg(sample.device)))
+                                 .arg(sample.channel);
+        channels.push_back(CaptureFormat::channelInfo(key, name));
+    }
+
+    Staging &block = it.value();
+    block.timestamps[size_t(block.count)] = sample.timestampNs;
+    block.values[size_t(block.count)] = sample.value;
+    if (++block.count == CaptureFormat::BlockSamples)
+        writeBlock(block);
+}
+
+void CaptureWriter::writeBlock(Staging &block) {
+    if (buffered + CaptureFormat::BlockSize > writeBuffer.size())
+        flushBuffer();
+
+    CaptureFormat::encodeBlock(writeBuffer.data() + buffered, block.key, block.nextIndex,
+                               block.timestamps.data(), block.values.data(), block.count);
+    buffered += CaptureFormat::BlockSize;
+
+    block.nextIndex += block.count;
+    block.count = 0;
+}
+
+void CaptureWriter::flushBuffer() {
+    if (buffered == 0)
+        return;
+    TraceScope trace("CaptureWriter::write");
+    if (file.write(writeBuffer.constData(), buffered) != buffered)
+        errorText = file.errorString();
+    buffered = 0;
+}
+
+void CaptureWriter::writeNameBlocks() {
+    if (channels.size() <= size_t(CaptureFormat::MaxChannels))
+        return;
+    const CaptureFormat::ChannelInfo *extra = channels.data() + CaptureFormat::MaxChannels;
+    const size_t count = channels.size() - size_t(CaptureFormat::MaxChannels);
+    for (size_t first = 0; first < count; first += CaptureFormat::NamesPerBlock) {
+        if (buffered + CaptureFormat::BlockSize > writeBuffer.size())
+            flushBuffer();
+        CaptureFormat::encodeNameBlock(writeBuffer.data() + buffered, extra + first,
+                                       qMin<size_t>(CaptureFormat::NamesPerBlock, count - first));
+        buffered += CaptureFormat::BlockSize;
+    }
+}
+
+void CaptureWriter::writeHeader() {
+    QByteArray bytes(CaptureFormat::HeaderSize, Qt::Uninitialized);
+    CaptureFormat::encodeHeader(bytes.data(), startEpochMs, startSteadyNs,
+                                channels.data(), channels.size());
+
+    const qint64 position = file.pos();
+    file.seek(0);
+    file.write(bytes);
+    if (position > CaptureFormat::HeaderSize)
+        file.seek(position);
+}
@@ -0,0 +1,83 @@
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <vector>
+
+#include "captureformat.h"
+#include "samplering.h"
+
+// Streams samples to a capture file from its own thread. Each port's reader
+// pushes its decoded samples into a lock-free ring registered with
+// addSource(), so recording never waits on disk or on the GUI; the writer
+// thread drains the rings, packs the samples into per-channel blocks and
+// writes them out in large sequential chunks. Channels beyond the header's
+// table get their names in name blocks at the end of the file.
+class CaptureWriter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CaptureWriter(QObject *parent = nullptr);
+    ~CaptureWriter();
+
+    bool isRecording() const { return recording.load(std::memory_order_acquire); }
+    quint64 samplesWritten() const { return written.load(std::memory_order_relaxed); }
+    // Samples a reader could not push because its ring was full
+    quint64 samplesDropped() const { return dropped.load(std::memory_order_relaxed); }
+    QString lastError() const { return errorText; }
+
+public slots:
+    // Must run on the writer thread (use a queued/blocking invoke)
+    bool start(const QString &fileName, const QStringList &deviceNames);
+    void stop();
+
+    // A ring one device's reader fills while recording; stop() and
+    // removeSource() drain it first. Must run on the writer thread.
+    void addSource(int device, SampleRing<Sample> *ring);
+    void removeSource(int device);
+
+private:
+    struct Source {
+        int device;
+        SampleRing<Sample> *ring;
+        quint64 reportedOverruns;
+    };
+
+    struct Staging {
+        quint32 key = 0;
+        qint64 nextIndex = 0;
+        int count = 0;
+        std::vector<qint64> timestamps;
+        std::vector<double> values;
+    };
+
+    void drain();
+    void drainSource(Source &source);
+    void stage(const Sample &sample);
+    void writeBlock(Staging &block);
+    void flushBuffer();
+    void writeHeader();
+    void writeNameBlocks();
+
+    std::vector<Source> sources;
+    QTimer *drainTimer = nullptr;
+    QFile file;
+    QByteArray writeBuffer;         // large sequential writes
+    qsizetype buffered = 0;
+    QHash<quint32, Staging> staging;
+    std::vector<CaptureFormat::ChannelInfo> channels;
+    QStringList names;
+    qint64 startEpochMs = 0;
+    qint64 startSteadyNs = 0;
+    QString errorText;
+    std::atomic<bool> recording{false};
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> dropped{0};
+};
+
+#endif // CAPTUREWRITER_H
@@ -0,0 +1,27 @@
+#ifndef CHANNELTRACE_H
+#define CHANNELTRACE_H
+
+#include <QAction>
+#include <QList>
+#include <QPointF>
+#include <QtCharts/QLineSeries>
+
+#include "samplebuffer.h"
+#include "decimationpyramid.h"
+
+// Per-channel state behind the Data View: retained samples, their
+// decimation pyramid and the series that shows the visible window.
+struct ChannelTrace {
+    explicit ChannelTrace(qsizetype retention) : history(retention) {}
+
+    SampleBuffer history;
+    DecimationPyramid decimation;
+    QLineSeries *series = nullptr;
+    QAction *visibilityAction = nullptr;
+    int plotTrace = -1;             // trace id in the raster plot
+    QList<QPointF> visiblePoints;
+    double lastValue = 0;
+    qint64 xOffset = 0;             // added to sample indexes to place them on the X axis
+};
+
+#endif // CHANNELTRACE_H
@@ -0,0 +1,325 @@
+#include "chartrenderer.h"
+#include "tracing.h"
+#include <QFileInfo>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPdfWriter>
+#include <QPolygonF>
+#include <QSvgGenerator>
+#include <cmath>
+
+void ChartPage::fitY() {
+    bool first = true;
+    for (const Trace &trace : traces) {
+        for (const QPointF &point : trace.points) {
+            yMin = first ? point.y() : qMin(yMin, point.y());
+            yMax = first ? point.y() : qMax(yMax, point.y());
+            first = false;
+        }
+    }
+    // Relative to the values, so large ones still get a span they can resolve
+    const qreal magnitude = qMax(qAbs(yMin), qAbs(yMax));
+    const qreal margin = yMax > yMin ? qMax((yMax - yMin) * 0.05, magnitude * 1e-9)
+                                     : qMax<qreal>(1.0, magnitude * 0.05);
+    yMin -= margin;
+    yMax += margin;
+}
+
+namespace ChartRenderer {
+
+qreal niceStep(qreal range, int ticks) {
+    if (!(range > 0)) return 1;
+    const qreal raw = range / qMax(1, ticks);
+    const qreal magnitude = std::pow(10.0, std::floor(std::log10(raw)));
+    const qreal residual = raw / magnitude;
+    return magnitude * (residual > 5 ? 10 : residual > 2 ? 5 : residual > 1 ? 2 : 1);
+}
+
+QVector<qreal> ticks(qreal min, qreal max, qreal step) {
+    QVector<qreal> out;
+    const qreal first = std::ceil(min / step);
+    const qreal count = std::floor(max / step) - first;
+    if (!(step > 0) || !(count >= 0))
+        return out;
+    const int n = int(qMin<qreal>(count, MaxTicks - 1)) + 1;
+    for (int i = 0; i < n; ++i) {
+        const qreal v = (first + i) * step;
+        if (out.isEmpty() || v != out.last())
+            out.append(v);
+    }
+    return out;
+}
+
+QColor traceColor(int index) {
+    static const QColor palette[] = {
+        QColor(0x20, 0x9f, 0xdf), QColor(0x99, 0xca, 0x53), QColor(0xf6, 0xa6, 0x25),
+        QColor(0x6d, 0x5f, 0xd5), QColor(0xbf, 0x59, 0x3e), QColor(0x2e, 0x8b, 0x57),
+        QColor(0xd6, 0x4f, 0x9a), QColor(0x60, 0x60, 0x60)
+    };
+    return palette[index % int(sizeof(palette) / sizeof(palette[0]))];
+}
+
+void render(QPainter &painter, const QRectF &rect, const ChartPage &page) {
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(rect, Qt::white);
+
+    // Text and lines scale with the output, so an 8K image looks like an
+    // enlarged screenshot rather than a tiny chart in a huge canvas
+    const qreal unit = qMax<qreal>(1.0, qMin(rect.width(), rect.height()) / 600.0);
+    QFont font = painter.font();
+    font.setPixelSize(qMax(1, qRound(11 * unit)));
+    painter.setFont(font);
+    const QFontMetricsF metrics(font, painter.device());
+    const qreal line = metrics.height();
+
+    const qreal xMin = page.xMin;
+    const qreal xMax = page.xMax > page.xMin ? page.xMax : page.xMin + 1;
+    const qreal yMin = page.yMin;
+    const qreal yMax = page.yMax > page.yMin ? page.yMax : page.yMin + 1;
+
+    // Y labels decide the left margin
+    const qreal yStep = niceStep(yMax - yMin, qMax(2, int(rect.height() / (60 * unit))));
+    qreal labelWidth = 0;
+    const QVector<qreal> yTicks = ticks(yMin, yMax, yStep);
+    for (qreal v : yTicks)
+        labelWidth = qMax(labelWidth, metrics.horizontalAdvance(QString::number(v, 'g', 6)));
+
+    const qreal top = page.title.isEmpty() ? line : line * 2.5;
+    const qreal bottom = line * (page.traces.empty() ? 2 : 3.5);
+    const QRectF plot = rect.adjusted(labelWidth + 12 * unit, top, -20 * unit, -bottom);
+    if (plot.width() <= 0 || plot.height() <= 0) {
+        painter.restore();
+        return;
+    }
+
+    auto mapX = [&](qreal x) { return plot.left() + (x - xMin) / (xMax - xMin) * plot.width(); };
+    auto mapY = [&](qreal y) { return plot.bottom() - (y - yMin) / (yMax - yMin) * plot.height(); };
+
+    if (!page.title.isEmpty()) {
+        QFont titleFont = font;
+        titleFont.setBold(true);
+        painter.setFont(titleFont);
+        painter.drawText(QRectF(rect.left(), rect.top(), rect.width(), top), Qt::AlignCenter, page.title);
+        painter.setFont(font);
+    }
+
+    // Grid and tick labels
+    const QPen gridPen(QColor(0xe0, 0xe0, 0xe0), unit * 0.75);
+    const QPen textPen(Qt::black);
+    for (qreal v : yTicks) {
+        const qreal y = mapY(v);
+        painter.setPen(gridPen);
+        painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+        painter.setPen(textPen);
+        painter.drawText(QRectF(rect.left(), y - line / 2, labelWidth + 6 * unit, line),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(v, 'g', 6));
+    }
+    const qreal xStep = niceStep(xMax - xMin, qMax(2, int(plot.width() / (100 * unit))));
+    for (qreal v : ticks(xMin, xMax, xStep)) {
+        const qreal x = mapX(v);
+        painter.setPen(gridPen);
+        painter.drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+        painter.setPen(textPen);
+        painter.drawText(QRectF(x - 50 * unit, plot.bottom() + 3 * unit, 100 * unit, line),
+                         Qt::AlignHCenter | Qt::AlignTop, QString::number(v, 'g', 10));
+    }
+
+    // Traces
+    painter.save();
+    painter.setClipRect(plot);
+    QPolygonF polyline;
+    for (const ChartPage::Trace &trace : page.traces) {
+        polyline.clear();
+        polyline.reserve(trace.points.size());
+        for (const QPointF &point : trace.points)
+            polyline.append(QPointF(mapX(point.x()), mapY(point.y())));
+        painter.setPen(QPen(trace.color, 1.5 * unit));
+        painter.drawPolyline(polyline);
+    }
+    painter.restore();
+
+    painter.setPen(QPen(Qt::black, unit));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(plot);
+
+    // Legend below the X labels, the axis label at its right end
+    const qreal legendY = plot.bottom() + line * 1.75;
+    qreal legendRight = rect.right();
+    if (!page.xLabel.isEmpty()) {
+        painter.setPen(textPen);
+        painter.drawText(QRectF(plot.left(), legendY, plot.width(), line), Qt::AlignRight | Qt::AlignTop,
+                         page.xLabel);
+        legendRight = plot.right() - metrics.horizontalAdvance(page.xLabel) - 12 * unit;
+    }
+    qreal x = plot.left();
+    for (const ChartPage::Trace &trace : page.traces) {
+        const qreal width = line + 4 * unit + metrics.horizontalAdvance(trace.name) + 12 * unit;
+        if (x + width > legendRight && x > plot.left())
+            break;
+        painter.fillRect(QRectF(x, legendY + line * 0.2, line, line * 0.6), trace.color);
+        painter.setPen(textPen);
+        painter.drawText(QPointF(x + line + 4 * unit, legendY + metrics.ascent()), trace.name);
+        x += width;
+    }
+
+    painter.restore();
+}
+
+}
+
+namespace {
+
+// Pages that were built up front
+class PageList : public ChartPageSource {
+public:
+    explicit PageList(std::vector<ChartPage> pages) : pages(std::move(pages)) {}
+    int pageCount() const override { return int(pages.size()); }
+    ChartPage page(int index) override { return pages[size_t(index)]; }
+
+private:
+    std::vector<ChartPage> pages;
+};
+
+}
+
+ChartExporter::ChartExporter(const QString &fileName, QSize pixelSize, int dpi, std::vector<ChartPage> pages,
+                             QObject *parent)
+    : ChartExporter(fileName, pixelSize, dpi, std::make_unique<PageList>(std::move(pages)), parent) {}
+
+ChartExporter::ChartExporter(const QString &fileName, QSize pixelSize, int dpi,
+                             std::unique_ptr<ChartPageSource> source, QObject *parent)
+    : QObject(parent), path(fileName), pixelSize(pixelSize), dpi(dpi), source(std::move(source)) {}
+
+ChartExporter::~ChartExporter() {
+    cancel();
+    if (worker) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+ChartExporter::Format ChartExporter::formatForFile(const QString &fileName) {
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png") return Format::Png;
+    if (suffix == "svg") return Format::Svg;
+    return Format::Pdf;
+}
+
+void ChartExporter::start() {
+    if (worker) return;
+    worker = QThread::create([this]() { emit finished(write()); });
+    worker->setObjectName("Chart Export");
+    worker->start();
+}
+
+bool ChartExporter::write() {
+    TraceScope trace("ChartExporter::write");
+    if (!source->prepare(&errorText))
+        return false;
+    if (source->pageCount() <= 0) {
+        errorText = "Nothing to render";
+        return false;
+    }
+
+    bool ok = false;
+    switch (formatForFile(path)) {
+    case Format::Png: ok = writeImage(); break;
+    case Format::Pdf: ok = writePdf(); break;
+    case Format::Svg: ok = writeSvg(); break;
+    }
+    return ok && !canceled.load(std::memory_order_relaxed);
+}
+
+bool ChartExporter::writeImage() {
+    QImage image(pixelSize, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        errorText = QString("Cannot allocate a %1x%2 image").arg(pixelSize.width()).arg(pixelSize.height());
+        return false;
+    }
+    const int dotsPerMeter = qRound(dpi / 0.0254);
+    image.setDotsPerMeterX(dotsPerMeter);
+    image.setDotsPerMeterY(dotsPerMeter);
+
+    for (int i = 0; i < source->pageCount(); ++i) {
+        QPainter painter(&image);
+        ChartRenderer::render(painter, image.rect(), source->page(i));
+        painter.end();
+
+        const QString name = pageFileName(i);
+        if (!image.save(name)) {
+            errorText = "Could not write " + name;
+            return false;
+        }
+        if (!advance(i + 1))
+            return false;
+    }
+    return true;
+}
+
+bool ChartExporter::writePdf() {
+    QPdfWriter writer(path);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setPageOrientation(QPageLayout::Landscape);
+    writer.setResolution(dpi);
+    ChartPage page = source->page(0);
+    writer.setTitle(page.title);
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        errorText = "Could not write " + path;
+        return false;
+    }
+    for (int i = 0; i < source->pageCount(); ++i) {
+        if (i > 0) {
+            writer.newPage();
+            page = source->page(i);
+        }
+        ChartRenderer::render(painter, QRectF(0, 0, writer.width(), writer.height()), page);
+        if (!advance(i + 1))
+            break;
+    }
+    painter.end();
+    return true;
+}
+
+bool ChartExporter::writeSvg() {
+    for (int i = 0; i < source->pageCount(); ++i) {
+        const ChartPage page = source->page(i);
+        QSvgGenerator generator;
+        generator.setFileName(pageFileName(i));
+        generator.setSize(pixelSize);
+        generator.setViewBox(QRect(QPoint(0, 0), pixelSize));
+        generator.setResolution(dpi);
+        generator.setTitle(page.title);
+
+        QPainter painter;
+        if (!painter.begin(&generator)) {
+            errorText = "Could not write " + generator.fileName();
+            return false;
+        }
+        ChartRenderer::render(painter, QRectF(QPointF(0, 0), QSizeF(pixelSize)), page);
+        painter.end();
+        if (!advance(i + 1))
+            return false;
+    }
+    return true;
+}
+
+QString ChartExporter::pageFileName(int page) const {
+    if (source->pageCount() <= 1)
+        return path;
+    const QFileInfo info(path);
+    return QString("%1/%2-%3.%4").arg(info.path(), info.completeBaseName()).arg(page + 1).arg(info.suffix());
+}
+
+bool ChartExporter::advance(int pagesDone) {
+    const int percent = int(qint64(pagesDone) * 100 / source->pageCount());
+    if (percent != reportedPercent) {
+        reportedPercent = percent;
+        emit progressChanged(percent);
+    }
+    return !canceled.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+#ifndef CHARTRENDERER_H
+#define CHARTRENDERER_H
+
+#include <QColor>
+#include <QList>
+#include <QObject>
+#include <QPainter>
+#include <QPointF>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// One chart page, already reduced to about two points per output pixel
+// column. Pages are built from the sample store (trace pyramids or a
+// capture), never from on-screen series, so they can be rendered at any
+// size without touching a widget.
+struct ChartPage {
+    struct Trace {
+        QString name;
+        QColor color;
+        QList<QPointF> points;
+    };
+
+    QString title;
+    QString xLabel;       // unit of the X axis, drawn below the tick labels
+    qreal xMin = 0;
+    qreal xMax = 1;
+    qreal yMin = 0;
+    qreal yMax = 1;
+    std::vector<Trace> traces;
+
+    // Sets the Y range from the points, with a small margin
+    void fitY();
+};
+
+// Draws chart pages with QPainter only, so it works on any paint device and
+// any thread (QImage, QPdfWriter, QSvgGenerator).
+namespace ChartRenderer {
+
+void render(QPainter &painter, const QRectF &rect, const ChartPage &page);
+
+// Colour for the n-th trace when there is no series to take it from
+QColor traceColor(int index);
+
+// Axis tick step: 1, 2 or 5 times a power of ten, about `ticks` steps over range
+qreal niceStep(qreal range, int ticks);
+
+// The multiples of `step` in [min, max], at most MaxTicks of them. They are
+// computed from an integer index, so a step below the values' precision
+// cannot stall the caller's loop.
+constexpr int MaxTicks = 1000;
+QVector<qreal> ticks(qreal min, qreal max, qreal step);
+
+}
+
+// Supplies the pages of an export one at a time on the exporter's thread, so
+// a long capture is reduced off the GUI thread and its pages are never all
+// in memory at once. prepare() runs before pageCount() and page().
+class ChartPageSource {
+public:
+    virtual ~ChartPageSource() = default;
+    virtual bool prepare(QString *errorString) { Q_UNUSED(errorString); return true; }
+    virtual int pageCount() const = 0;
+    virtual ChartPage page(int index) = 0;
+};
+
+// Renders pages offscreen on a worker thread and writes PNG, PDF or SVG.
+// A PDF gets one page per ChartPage; PNG and SVG write one file per page,
+// numbered when there is more than one.
+class ChartExporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Format { Png, Pdf, Svg };
+
+    // pixelSize is the image size for PNG/SVG; PDF pages are A4 landscape at `dpi`
+    ChartExporter(const QString &fileName, QSize pixelSize, int dpi, std::vector<ChartPage> pages,
+                  QObject *parent = nullptr);
+    ChartExporter(const QString &fileName, QSize pixelSize, int dpi, std::unique_ptr<ChartPageSource> source,
+                  QObject *parent = nullptr);
+    ~ChartExporter();
+
+    void start();
+    void cancel() { canceled.store(true, std::memory_order_relaxed); }   // thread-safe
+    bool isCanceled() const { return canceled.load(std::memory_order_relaxed); }
+
+    // Renders and writes synchronously on the calling thread
+    bool write();
+
+    QString fileName() const { return path; }
+    QString errorString() const { return errorText; }
+
+    // Png for .png, Svg for .svg, Pdf otherwise
+    static Format formatForFile(const QString &fileName);
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool ok);
+
+private:
+    bool writeImage();
+    bool writePdf();
+    bool writeSvg();
+    QString pageFileName(int page) const;
+    bool advance(int pagesDone);   // false once canceled
+
+    QString path;
+    QSize pixelSize;
+    int dpi;
+    std::unique_ptr<ChartPageSource> source;
+    QThread *worker = nullptr;
+    std::atomic<bool> canceled{false};
+    int reportedPercent = -1;
+    QString errorText;
+};
+
+#endif // CHARTRENDERER_H
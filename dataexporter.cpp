@@ -0,0 +1,228 @@
+#include "dataexporter.h"
+#include "captureformat.h"
+#include "tracing.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <charconv>
+#include <cstring>
+
+static const qsizetype WriteBufferSize = 4 << 20;
+static const qint64 ProgressStep = 1 << 16;      // samples between progress/cancel checks
+
+DataExporter::DataExporter(const QString &fileName, Format format, std::vector<Channel> channels,
+                           QObject *parent)
+    : QObject(parent), path(fileName), format(format), channels(std::move(channels)) {
+    for (const Channel &channel : this->channels)
+        total += channel.samples.size();
+}
+
+DataExporter::~DataExporter() {
+    cancel();
+    if (worker) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+DataExporter::Format DataExporter::formatForFile(const QString &fileName) {
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "csv") return Format::Csv;
+    if (suffix == "cdx") return Format::Capture;
+    return Format::RawBinary;
+}
+
+void DataExporter::start() {
+    if (worker) return;
+    worker = QThread::create([this]() { run(); });
+    worker->setObjectName("Data Export");
+    worker->start();
+}
+
+void DataExporter::run() {
+    TraceScope trace("DataExporter::run");
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        errorText = out.errorString();
+        emit finished(false);
+        return;
+    }
+    file = &out;
+    buffer.resize(WriteBufferSize);
+    buffered = 0;
+
+    bool ok = false;
+    switch (format) {
+    case Format::Csv: ok = writeCsv(); break;
+    case Format::Capture: ok = writeCapture(); break;
+    case Format::RawBinary: ok = writeRaw(); break;
+    }
+    ok = flush() && ok && !canceled.load(std::memory_order_relaxed);
+
+    // A canceled or failed export leaves whatever was at the path untouched
+    if (!ok) {
+        out.cancelWriting();
+    } else if (!out.commit()) {
+        errorText = out.errorString();
+        ok = false;
+    }
+    file = nullptr;
+    buffer = QByteArray();
+
+    if (ok)
+        emit progressChanged(100);
+    emit finished(ok);
+}
+
+bool DataExporter::writeCsv() {
+    static const char header[] = "series,index,timestamp_ns,value\n";
+    if (!reserve(sizeof(header)))
+        return false;
+    std::memcpy(buffer.data() + buffered, header, sizeof(header) - 1);
+    buffered += qsizetype(sizeof(header) - 1);
+
+    for (const Channel &channel : channels) {
+        // Names are port names or file names; quote them only if needed
+        QByteArray name = channel.name.toUtf8();
+        if (name.contains(',') || name.contains('"'))
+            name = '"' + name.replace("\"", "\"\"") + '"';
+        const qsizetype maxRow = name.size() + 80;
+
+        const SampleBuffer::Snapshot &samples = channel.samples;
+        qint64 sinceProgress = 0;
+        for (qint64 index = samples.firstIndex(); index < samples.endIndex(); ++index) {
+            const Sample &sample = samples.at(index);
+            if (!reserve(maxRow))
+                return false;
+            char *pos = buffer.data() + buffered;
+            char *const last = pos + maxRow;
+            std::memcpy(pos, name.constData(), size_t(name.size()));
+            pos += name.size();
+            *pos++ = ',';
+            pos = std::to_chars(pos, last, index).ptr;
+            *pos++ = ',';
+            pos = std::to_chars(pos, last, sample.timestampNs).ptr;
+            *pos++ = ',';
+            pos = std::to_chars(pos, last, sample.value).ptr;
+            *pos++ = '\n';
+            buffered = pos - buffer.data();
+
+            if (++sinceProgress == ProgressStep) {
+                if (!advance(sinceProgress))
+                    return false;
+                sinceProgress = 0;
+            }
+        }
+        if (!advance(sinceProgress))
+            return false;
+    }
+    return true;
+}
+
+bool DataExporter::writeCapture() {
+    std::vector<CaptureFormat::ChannelInfo> table;
+    qint64 startSteadyNs = 0;
+    bool haveStart = false;
+    for (const Channel &channel : channels) {
+        table.push_back(CaptureFormat::channelInfo(CaptureFormat::channelKey(channel.device, channel.channel),
+                                                   channel.name));
+        if (!channel.samples.isEmpty()) {
+            const qint64 first = channel.samples.at(channel.samples.firstIndex()).timestampNs;
+            startSteadyNs = haveStart ? qMin(startSteadyNs, first) : first;
+            haveStart = true;
+        }
+    }
+
+    // Map the earliest sample back to wall-clock time; imported logs have no
+    // real timestamps, so for them this is only approximate
+    const qint64 startEpochMs = QDateTime::currentMSecsSinceEpoch()
+                                - qMax<qint64>(0, steadyClockNs() - startSteadyNs) / 1000000;
+    if (!reserve(CaptureFormat::HeaderSize))
+        return false;
+    CaptureFormat::encodeHeader(buffer.data() + buffered, startEpochMs, startSteadyNs,
+                                table.data(), table.size());
+    buffered += CaptureFormat::HeaderSize;
+
+    std::vector<qint64> timestamps(CaptureFormat::BlockSamples);
+    std::vector<double> values(CaptureFormat::BlockSamples);
+    for (size_t c = 0; c < channels.size(); ++c) {
+        const SampleBuffer::Snapshot &samples = channels[c].samples;
+        for (qint64 first = 0; first < samples.size(); first += CaptureFormat::BlockSamples) {
+            const int count = int(qMin<qint64>(CaptureFormat::BlockSamples, samples.size() - first));
+            for (int i = 0; i < count; ++i) {
+                const Sample &sample = samples.at(samples.firstIndex() + first + i);
+                timestamps[size_t(i)] = sample.timestampNs;
+                values[size_t(i)] = sample.value;
+            }
+
+            // Block indexes restart at zero, as they would for a fresh recording
+            if (!reserve(CaptureFormat::BlockSize))
+                return false;
+            CaptureFormat::encodeBlock(buffer.data() + buffered, table[c].key, first,
+                                       timestamps.data(), values.data(), count);
+            buffered += CaptureFormat::BlockSize;
+            if (!advance(count))
+                return false;
+        }
+    }
+
+    // Channels the header has no room for are named after the data
+    for (size_t first = CaptureFormat::MaxChannels; first < table.size(); first += CaptureFormat::NamesPerBlock) {
+        if (!reserve(CaptureFormat::BlockSize))
+            return false;
+        CaptureFormat::encodeNameBlock(buffer.data() + buffered, table.data() + first,
+                                       qMin<size_t>(CaptureFormat::NamesPerBlock, table.size() - first));
+        buffered += CaptureFormat::BlockSize;
+    }
+    return true;
+}
+
+bool DataExporter::writeRaw() {
+    for (const Channel &channel : channels) {
+        const SampleBuffer::Snapshot &samples = channel.samples;
+        qint64 sinceProgress = 0;
+        for (qint64 index = samples.firstIndex(); index < samples.endIndex(); ++index) {
+            const Sample &sample = samples.at(index);
+            if (!reserve(sizeof(RawRecord)))
+                return false;
+            const RawRecord record{index, sample.timestampNs, sample.value, channel.device, channel.channel, 0};
+            std::memcpy(buffer.data() + buffered, &record, sizeof(record));
+            buffered += qsizetype(sizeof(record));
+
+            if (++sinceProgress == ProgressStep) {
+                if (!advance(sinceProgress))
+                    return false;
+                sinceProgress = 0;
+            }
+        }
+        if (!advance(sinceProgress))
+            return false;
+    }
+    return true;
+}
+
+bool DataExporter::reserve(qsizetype bytes) {
+    if (buffered + bytes <= buffer.size())
+        return true;
+    return flush();
+}
+
+bool DataExporter::flush() {
+    TraceScope trace("DataExporter::write");
+    if (buffered == 0)
+        return true;
+    const bool ok = file->write(buffer.constData(), buffered) == buffered;
+    if (!ok)
+        errorText = file->errorString();
+    buffered = 0;
+    return ok;
+}
+
+bool DataExporter::advance(qint64 samples) {
+    const qint64 done = written.fetch_add(samples, std::memory_order_relaxed) + samples;
+    const int percent = total ? int(done * 100 / total) : 100;
+    if (percent != lastPercent) {
+        lastPercent = percent;
+        emit progressChanged(percent);
+    }
+    return !canceled.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,91 @@
+#ifndef DATAEXPORTER_H
+#define DATAEXPORTER_H
+
+#include <QObject>
+#include <QSaveFile>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#include "samplebuffer.h"
+
+// Writes a snapshot of retained samples to disk on a worker thread. The GUI
+// hands over immutable snapshots of the trace buffers, which cost no sample
+// copies, and the exporter formats and writes them through a large buffer,
+// so neither formatting nor disk I/O runs on the GUI thread. The file only
+// replaces what was at the path once the export has completed.
+//
+// Formats:
+//   Csv        series,index,timestamp_ns,value - one row per sample
+//   Capture    a .cdx capture (per-channel blocks of timestamp and value
+//              columns with min/max statistics), readable by CaptureFile
+//   RawBinary  packed little-endian RawRecords, channel after channel
+class DataExporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Format { Csv, Capture, RawBinary };
+
+    struct Channel {
+        QString name;
+        quint16 device = 0;
+        quint16 channel = 0;
+        SampleBuffer::Snapshot samples;
+    };
+
+    struct RawRecord {
+        qint64 index;
+        qint64 timestampNs;
+        double value;
+        quint16 device;
+        quint16 channel;
+        quint32 reserved;
+    };
+    static_assert(sizeof(RawRecord) == 32, "unexpected raw record padding");
+
+    DataExporter(const QString &fileName, Format format, std::vector<Channel> channels,
+                 QObject *parent = nullptr);
+    ~DataExporter();
+
+    void start();
+    void cancel() { canceled.store(true, std::memory_order_relaxed); }   // thread-safe
+    bool isCanceled() const { return canceled.load(std::memory_order_relaxed); }
+
+    QString fileName() const { return path; }
+    QString errorString() const { return errorText; }
+    qint64 samplesWritten() const { return written.load(std::memory_order_relaxed); }
+
+    // Csv for .csv, Capture for .cdx, RawBinary otherwise
+    static Format formatForFile(const QString &fileName);
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool ok);
+
+private:
+    void run();
+    bool writeCsv();
+    bool writeCapture();
+    bool writeRaw();
+    bool reserve(qsizetype bytes);   // flushes when fewer than `bytes` are free
+    bool flush();
+    bool advance(qint64 samples);    // false once canceled
+
+    QString path;
+    Format format;
+    std::vector<Channel> channels;
+    qint64 total = 0;
+    QThread *worker = nullptr;
+    std::atomic<bool> canceled{false};
+    std::atomic<qint64> written{0};
+    int lastPercent = -1;
+
+    // Only touched by the worker
+    QSaveFile *file = nullptr;
+    QByteArray buffer;
+    qsizetype buffered = 0;
+    QString errorText;
+};
+
+#endif // DATAEXPORTER_H
@@ -0,0 +1,105 @@
+#include "decimationpyramid.h"
+
+DecimationPyramid::DecimationPyramid(int baseBucket, int factor, int levelCount)
+    : baseBucket(qMax(2, baseBucket)), factor(qMax(2, factor)) {
+    levels.resize(size_t(qMax(1, levelCount)));
+    qint64 span = this->baseBucket;
+    for (Level &level : levels) {
+        level.span = span;
+        span *= this->factor;
+    }
+}
+
+void DecimationPyramid::clear() {
+    for (Level &level : levels) {
+        level.buckets.clear();
+        level.partialCount = 0;
+    }
+    count = 0;
+}
+
+void DecimationPyramid::merge(Bucket &into, const Bucket &from, bool first) {
+    if (first) {
+        into = from;
+        return;
+    }
+    if (from.min < into.min) {
+        into.min = from.min;
+        into.minIndex = from.minIndex;
+    }
+    if (from.max > into.max) {
+        into.max = from.max;
+        into.maxIndex = from.maxIndex;
+    }
+}
+
+void DecimationPyramid::append(double value) {
+    const Bucket sample{value, value, count, count};
+    ++count;
+
+    Level &base = levels[0];
+    merge(base.partial, sample, base.partialCount == 0);
+    if (++base.partialCount == baseBucket) {
+        base.partialCount = 0;
+        push(0, base.partial);
+    }
+}
+
+void DecimationPyramid::push(size_t level, const Bucket &bucket) {
+    levels[level].buckets.push_back(bucket);
+
+    // Fold completed buckets upwards; amortised O(1) per sample
+    if (level + 1 >= levels.size())
+        return;
+    Level &parent = levels[level + 1];
+    merge(parent.partial, bucket, parent.partialCount == 0);
+    if (++parent.partialCount == factor) {
+        parent.partialCount = 0;
+        push(level + 1, parent.partial);
+    }
+}
+
+int DecimationPyramid::chooseLevel(qint64 span, int pixels) const {
+    if (span <= 2 * qint64(qMax(1, pixels)))
+        return -1;
+
+    for (int level = 0; level < levelCount(); ++level) {
+        if (span / bucketSize(level) <= pixels)
+            return level;
+    }
+    return levelCount() - 1;
+}
+
+void DecimationPyramid::appendBucket(const Bucket &bucket, QList<QPointF> &out) {
+    if (bucket.minIndex <= bucket.maxIndex) {
+        out.append(QPointF(bucket.minIndex, bucket.min));
+        if (bucket.maxIndex != bucket.minIndex)
+            out.append(QPointF(bucket.maxIndex, bucket.max));
+    } else {
+        out.append(QPointF(bucket.maxIndex, bucket.max));
+        out.append(QPointF(bucket.minIndex, bucket.min));
+    }
+}
+
+void DecimationPyramid::query(qint64 first, qint64 last, int level, QList<QPointF> &out) const {
+    first = qMax<qint64>(0, first);
+    last = qMin(last, count);
+    if (first >= last || level < 0)
+        return;
+    level = qMin(level, levelCount() - 1);
+
+    const Level &l = levels[size_t(level)];
+    const qint64 firstBucket = first / l.span;
+    const qint64 lastBucket = qMin<qint64>((last + l.span - 1) / l.span, qint64(l.buckets.size()));
+    for (qint64 b = firstBucket; b < lastBucket; ++b)
+        appendBucket(l.buckets[size_t(b)], out);
+
+    // The tail not yet summarised at this level comes from finer levels
+    const qint64 covered = qMax(first, qint64(l.buckets.size()) * l.span);
+    if (covered < last) {
+        if (level > 0)
+            query(covered, last, level - 1, out);
+        else if (l.partialCount > 0)
+            appendBucket(l.partial, out);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef DECIMATIONPYRAMID_H
+#define DECIMATIONPYRAMID_H
+
+#include <QList>
+#include <QPointF>
+#include <vector>
+
+// Multi-resolution min/max summary of a sample stream, built incrementally
+// as samples arrive. Level 0 buckets cover baseBucket samples and each
+// further level covers `factor` buckets of the level below, so drawing any
+// range costs about the same number of points however long the capture is.
+class DecimationPyramid {
+public:
+    struct Bucket {
+        double min = 0.0;
+        double max = 0.0;
+        qint64 minIndex = 0;
+        qint64 maxIndex = 0;
+    };
+
+    explicit DecimationPyramid(int baseBucket = 16, int factor = 4, int levels = 10);
+
+    void append(double value);
+    void clear();
+
+    qint64 sampleCount() const { return count; }
+    int levelCount() const { return int(levels.size()); }
+    qint64 bucketSize(int level) const { return levels[size_t(level)].span; }
+
+    // Coarsest resolution that still gives about two points per pixel for a
+    // range of `span` samples. Returns -1 when raw samples should be drawn.
+    int chooseLevel(qint64 span, int pixels) const;
+
+    // Appends the min/max envelope of [first, last) at `level` to out, in
+    // index order. Parts of the range not yet covered by complete buckets at
+    // that level are filled in from finer levels.
+    void query(qint64 first, qint64 last, int level, QList<QPointF> &out) const;
+
+private:
+    struct Level {
+        qint64 span = 0;              // samples per bucket
+        std::vector<Bucket> buckets;  // complete buckets
+        Bucket partial;
+        int partialCount = 0;         // child buckets (or samples) in partial
+    };
+
+    void push(size_t level, const Bucket &bucket);
+    static void merge(Bucket &into, const Bucket &from, bool first);
+    static void appendBucket(const Bucket &bucket, QList<QPointF> &out);
+
+    std::vector<Level> levels;
+    int baseBucket;
+    int factor;
+    qint64 count = 0;
+};
+
+#endif // DECIMATIONPYRAMID_H
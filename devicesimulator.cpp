@@ -0,0 +1,316 @@
+#include "devicesimulator.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QSettings>
+#include <QTimer>
+#include <QtEndian>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// Longest text field: a float in shortest form plus the separator
+static const qsizetype MaxFieldBytes = 32;
+// Sync, seq, channel, type, float32 payload, crc16
+static const qsizetype FrameBytes = 11;
+static const double Pi = 3.14159265358979323846;
+
+SimulatorSettings SimulatorSettings::load() {
+    SimulatorSettings s;
+    QSettings settings;
+    settings.beginGroup("simulator");
+    s.waveform = Waveform(settings.value("waveform", int(s.waveform)).toInt());
+    s.output = Output(settings.value("output", int(s.output)).toInt());
+    s.framing = SampleDecoder::Kind(settings.value("framing", int(s.framing)).toInt());
+    s.samplesPerSecond = settings.value("samplesPerSecond", s.samplesPerSecond).toDouble();
+    s.channels = settings.value("channels", s.channels).toInt();
+    s.amplitude = settings.value("amplitude", s.amplitude).toDouble();
+    s.frequencyHz = settings.value("frequencyHz", s.frequencyHz).toDouble();
+    s.noise = settings.value("noise", s.noise).toDouble();
+    s.corruption = settings.value("corruption", s.corruption).toDouble();
+    s.seed = settings.value("seed", s.seed).toUInt();
+    settings.endGroup();
+    return s;
+}
+
+void SimulatorSettings::save() const {
+    QSettings settings;
+    settings.beginGroup("simulator");
+    settings.setValue("waveform", int(waveform));
+    settings.setValue("output", int(output));
+    settings.setValue("framing", int(framing));
+    settings.setValue("samplesPerSecond", samplesPerSecond);
+    settings.setValue("channels", channels);
+    settings.setValue("amplitude", amplitude);
+    settings.setValue("frequencyHz", frequencyHz);
+    settings.setValue("noise", noise);
+    settings.setValue("corruption", corruption);
+    settings.setValue("seed", seed);
+    settings.endGroup();
+}
+
+SignalGenerator::SignalGenerator(const SimulatorSettings &settings)
+    : settings(settings), random(settings.seed), noise(0.0, settings.noise > 0 ? settings.noise : 1.0) {
+    // Binary frames carry the channel in one byte
+    this->settings.channels = qBound(1, settings.channels, 256);
+    this->settings.samplesPerSecond = qMax(1.0, settings.samplesPerSecond);
+}
+
+qint64 SignalGenerator::samplesDue(qint64 elapsedNs) {
+    const qint64 channels = settings.channels;
+    const qint64 target = qint64(double(elapsedNs) * settings.samplesPerSecond / 1e9);
+    const qint64 maxBurst = qMax(channels, qint64(settings.samplesPerSecond / 10));
+    if (target - nextValue > maxBurst)
+        nextValue = (target - maxBurst) / channels * channels;
+    return qMax<qint64>(0, target - nextValue);
+}
+
+double SignalGenerator::valueAt(int channel, qint64 tick) {
+    // Channels share the waveform, evenly spread in phase
+    const double t = double(tick) * settings.channels / settings.samplesPerSecond;
+    double phase = settings.frequencyHz * t + double(channel) / settings.channels;
+    phase -= std::floor(phase);
+
+    double value = 0;
+    switch (settings.waveform) {
+    case SimulatorSettings::Waveform::Sine: value = settings.amplitude * std::sin(2 * Pi * phase); break;
+    case SimulatorSettings::Waveform::Square: value = phase < 0.5 ? settings.amplitude : -settings.amplitude; break;
+    case SimulatorSettings::Waveform::Sawtooth: value = settings.amplitude * (2 * phase - 1); break;
+    case SimulatorSettings::Waveform::Noise: value = settings.amplitude * (2 * unit(random) - 1); break;
+    }
+    if (settings.noise > 0)
+        value += noise(random);
+    return value;
+}
+
+void SignalGenerator::corrupt(char *record, qsizetype size) {
+    if (settings.corruption <= 0 || unit(random) >= settings.corruption)
+        return;
+    const quint32 bits = random();
+    record[bits % quint32(size)] ^= char(1 << ((bits >> 16) % 8));
+}
+
+qsizetype SignalGenerator::generate(char *out, qsizetype capacity, qint64 &samples) {
+    const int channels = settings.channels;
+    qsizetype pos = 0;
+
+    if (settings.framing == SampleDecoder::Kind::TextLines) {
+        const qsizetype maxLine = qsizetype(channels) * MaxFieldBytes;
+        while (samples >= channels && capacity - pos >= maxLine) {
+            char *line = out + pos;
+            char *p = line;
+            const qint64 tick = nextValue / channels;
+            for (int channel = 0; channel < channels; ++channel) {
+                if (channel > 0) *p++ = ',';
+                p = std::to_chars(p, line + maxLine, float(valueAt(channel, tick))).ptr;
+            }
+            *p++ = '\n';
+            corrupt(line, p - line);
+
+            pos += p - line;
+            nextValue += channels;
+            samples -= channels;
+            generated += quint64(channels);
+        }
+        return pos;
+    }
+
+    while (samples > 0 && capacity - pos >= FrameBytes) {
+        quint8 *frame = reinterpret_cast<quint8 *>(out + pos);
+        const int channel = int(nextValue % channels);
+        const float value = float(valueAt(channel, nextValue / channels));
+        quint32 raw;
+        std::memcpy(&raw, &value, sizeof(raw));
+
+        frame[0] = BinaryFrameDecoder::Sync0;
+        frame[1] = BinaryFrameDecoder::Sync1;
+        frame[2] = sequence++;
+        frame[3] = quint8(channel);
+        frame[4] = BinaryFrameDecoder::Float32;
+        qToLittleEndian<quint32>(raw, frame + 5);
+        qToLittleEndian<quint16>(BinaryFrameDecoder::crc16(frame + 2, 7), frame + 9);
+        corrupt(out + pos, FrameBytes);
+
+        pos += FrameBytes;
+        ++nextValue;
+        --samples;
+        ++generated;
+    }
+    return pos;
+}
+
+PtySimulator::PtySimulator(const SimulatorSettings &settings)
+    : settings(settings) {}
+
+PtySimulator::~PtySimulator() {
+    stop();
+}
+
+bool PtySimulator::start() {
+#ifdef Q_OS_UNIX
+    if (worker) return true;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    const char *name = master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0 ? ptsname(master) : nullptr;
+    if (!name) {
+        errorText = QString::fromLocal8Bit(std::strerror(errno));
+        stop();
+        return false;
+    }
+    path = QString::fromLocal8Bit(name);
+
+    // Raw mode, so binary frames are not translated, and never block the generator
+    termios mode;
+    if (tcgetattr(master, &mode) == 0) {
+        cfmakeraw(&mode);
+        tcsetattr(master, TCSANOW, &mode);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    stopping.store(false, std::memory_order_relaxed);
+    worker = QThread::create([this]() { run(); });
+    worker->setObjectName("Simulator " + path);
+    worker->start();
+    return true;
+#else
+    errorText = "Pseudo terminals are not supported on this platform";
+    return false;
+#endif
+}
+
+void PtySimulator::stop() {
+    if (worker) {
+        stopping.store(true, std::memory_order_relaxed);
+        worker->wait();
+        delete worker;
+        worker = nullptr;
+    }
+#ifdef Q_OS_UNIX
+    if (master >= 0) {
+        ::close(master);
+        master = -1;
+    }
+#endif
+}
+
+void PtySimulator::run() {
+#ifdef Q_OS_UNIX
+    SignalGenerator generator(settings);
+    std::vector<char> buffer(64 * 1024);
+    const qint64 start = steadyClockNs();
+
+    // What the terminal did not take of the last write. It goes out before
+    // anything new, so a partial write never cuts a record; records due
+    // while it is pending are dropped whole.
+    std::vector<char> pending;
+    auto send = [this](const char *data, size_t size) {
+        const qsizetype sent = qMax<qsizetype>(0, ::write(master, data, size));
+        written.fetch_add(quint64(sent), std::memory_order_relaxed);
+        return size_t(sent);
+    };
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (!pending.empty())
+            pending.erase(pending.begin(), pending.begin() + ptrdiff_t(send(pending.data(), pending.size())));
+
+        qint64 due = generator.samplesDue(steadyClockNs() - start);
+        while (due > 0) {
+            const qsizetype n = generator.generate(buffer.data(), qsizetype(buffer.size()), due);
+            if (n == 0) break;
+            if (!pending.empty()) {
+                dropped.fetch_add(quint64(n), std::memory_order_relaxed);
+                continue;
+            }
+            const size_t sent = send(buffer.data(), size_t(n));
+            pending.assign(buffer.begin() + ptrdiff_t(sent), buffer.begin() + n);
+        }
+        QThread::usleep(1000);
+    }
+#endif
+}
+
+bool isSimulatorInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--simulate") == 0)
+            return true;
+    }
+    return false;
+}
+
+int runSimulator(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Streams a simulated device into a pseudo terminal.");
+    parser.addHelpOption();
+    const QCommandLineOption simulateOption("simulate", "Run the device simulator.");
+    const QCommandLineOption rateOption("rate", "Samples per second over all channels.", "rate", "1000");
+    const QCommandLineOption channelsOption("channels", "Channel count (1-256).", "count", "1");
+    const QCommandLineOption framingOption("framing", "Framing: text or binary.", "framing", "text");
+    const QCommandLineOption waveformOption("waveform", "Waveform: sine, square, sawtooth or noise.", "waveform", "sine");
+    const QCommandLineOption amplitudeOption("amplitude", "Waveform amplitude.", "value", "100");
+    const QCommandLineOption frequencyOption("frequency", "Waveform frequency in Hz.", "hz", "1");
+    const QCommandLineOption noiseOption("noise", "Standard deviation of added noise.", "sigma", "0");
+    const QCommandLineOption corruptOption("corrupt", "Probability that a record is corrupted.", "probability", "0");
+    const QCommandLineOption seedOption("seed", "Random seed.", "seed", "1");
+    const QCommandLineOption durationOption("duration", "Seconds to run (default: until killed).", "seconds");
+    parser.addOptions({ simulateOption, rateOption, channelsOption, framingOption, waveformOption,
+                        amplitudeOption, frequencyOption, noiseOption, corruptOption, seedOption,
+                        durationOption });
+
+    if (!parser.parse(app.arguments())) {
+        std::fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 1;
+    }
+    if (parser.isSet("help")) {
+        std::fputs(qPrintable(parser.helpText()), stdout);
+        return 0;
+    }
+
+    SimulatorSettings settings;
+    settings.output = SimulatorSettings::Output::PseudoTerminal;
+    settings.samplesPerSecond = parser.value(rateOption).toDouble();
+    settings.channels = parser.value(channelsOption).toInt();
+    settings.amplitude = parser.value(amplitudeOption).toDouble();
+    settings.frequencyHz = parser.value(frequencyOption).toDouble();
+    settings.noise = parser.value(noiseOption).toDouble();
+    settings.corruption = parser.value(corruptOption).toDouble();
+    settings.seed = parser.value(seedOption).toUInt();
+
+    const QString framing = parser.value(framingOption).toLower();
+    const QStringList waveforms = { "sine", "square", "sawtooth", "noise" };
+    const int waveform = waveforms.indexOf(parser.value(waveformOption).toLower());
+    if ((framing != "text" && framing != "binary") || waveform < 0 || settings.samplesPerSecond <= 0
+        || settings.channels < 1 || settings.channels > 256) {
+        std::fprintf(stderr, "Invalid --framing, --waveform, --rate or --channels.\n");
+        return 1;
+    }
+    settings.framing = framing == "binary" ? SampleDecoder::Kind::BinaryFrames : SampleDecoder::Kind::TextLines;
+    settings.waveform = SimulatorSettings::Waveform(waveform);
+
+    PtySimulator simulator(settings);
+    if (!simulator.start()) {
+        std::fprintf(stderr, "%s\n", qPrintable(simulator.errorString()));
+        return 1;
+    }
+    std::printf("%s\n", qPrintable(simulator.slavePath()));
+    std::fflush(stdout);
+
+    if (parser.isSet(durationOption))
+        QTimer::singleShot(int(parser.value(durationOption).toDouble() * 1000), &app, &QCoreApplication::quit);
+    const int result = app.exec();
+
+    simulator.stop();
+    std::fprintf(stderr, "%llu bytes written, %llu dropped\n",
+                 (unsigned long long)simulator.bytesWritten(), (unsigned long long)simulator.bytesDropped());
+    return result;
+}
@@ -0,0 +1,105 @@
+#ifndef DEVICESIMULATOR_H
+#define DEVICESIMULATOR_H
+
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <random>
+
+#include "sampledecoder.h"
+
+// Configuration of a simulated device. Stored in QSettings so the dialog
+// reopens with the last load profile.
+struct SimulatorSettings {
+    enum class Waveform { Sine, Square, Sawtooth, Noise };
+    enum class Output { Direct, PseudoTerminal };
+
+    Waveform waveform = Waveform::Sine;
+    Output output = Output::Direct;
+    SampleDecoder::Kind framing = SampleDecoder::Kind::TextLines;
+    double samplesPerSecond = 1000;   // over all channels
+    int channels = 1;
+    double amplitude = 100;
+    double frequencyHz = 1;
+    double noise = 0;                 // standard deviation added to every value
+    double corruption = 0;            // probability that a record has a flipped bit
+    quint32 seed = 1;
+
+    static SimulatorSettings load();
+    void save() const;
+};
+
+// Produces the byte stream a device with the given settings would send:
+// text lines carrying one value per channel, or one binary frame per value
+// in the BinaryFrameDecoder format. The output only depends on the settings
+// (including the seed), so a run can be reproduced exactly.
+class SignalGenerator {
+public:
+    explicit SignalGenerator(const SimulatorSettings &settings);
+
+    // Samples that should have been sent `elapsedNs` after the start but
+    // were not yet. A generator that fell far behind skips ahead instead of
+    // bursting.
+    qint64 samplesDue(qint64 elapsedNs);
+
+    // Writes whole records for up to `samples` values; returns the bytes
+    // written and reduces `samples` by the values they carry
+    qsizetype generate(char *out, qsizetype capacity, qint64 &samples);
+
+    quint64 samplesGenerated() const { return generated; }
+
+private:
+    double valueAt(int channel, qint64 tick);
+    void corrupt(char *record, qsizetype size);
+
+    SimulatorSettings settings;
+    std::mt19937 random;
+    std::normal_distribution<double> noise;
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    qint64 nextValue = 0;      // values generated, counted across channels
+    quint64 generated = 0;
+    quint8 sequence = 0;
+};
+
+// Writes a simulated device's stream into the master side of a pseudo
+// terminal from its own thread; the slave side (slavePath()) can be opened
+// like any serial port. When nobody reads fast enough whole records are
+// dropped, as a real device would.
+class PtySimulator {
+public:
+    explicit PtySimulator(const SimulatorSettings &settings);
+    ~PtySimulator();
+
+    bool start();
+    void stop();
+
+    QString slavePath() const { return path; }
+    QString errorString() const { return errorText; }
+    quint64 bytesWritten() const { return written.load(std::memory_order_relaxed); }
+    quint64 bytesDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    SimulatorSettings settings;
+    int master = -1;
+    QString path;
+    QString errorText;
+    QThread *worker = nullptr;
+    std::atomic<bool> stopping{false};
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> dropped{0};
+};
+
+// Headless pseudo-terminal device for load tests without hardware:
+//
+//   MenuBar --simulate [--rate N] [--channels N] [--framing text|binary]
+//           [--waveform sine|square|sawtooth|noise] [--noise SIGMA]
+//           [--corrupt PROBABILITY] [--seed N] [--duration SECONDS]
+//
+// Prints the slave path, then streams until the duration ends or the
+// process is killed.
+bool isSimulatorInvocation(int argc, char *argv[]);
+int runSimulator(int argc, char *argv[]);
+
+#endif // DEVICESIMULATOR_H
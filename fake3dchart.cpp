@@ -1,35 +1,132 @@
 #include "fake3dchart.h"
+#include "tracing.h"
+#include <QElapsedTimer>
 #include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+
+// Above this many bins in the dirty box, recolouring every cell is cheaper
+static const qint64 MaxPartialBins = 1 << 16;
 
 Fake3DChart::Fake3DChart(QWidget *parent) : QWidget(parent) {
     setMinimumSize(400, 300);
-    memset(frequency, 0, sizeof(frequency));
-}
 
-void Fake3DChart::addDataPoint(int x, int y) {
-    if (x < 0 || x >= MAX_X || y < 0 || y >= MAX_Y) return;
-    frequency[x][y]++;
-    if (frequency[x][y] > maxFrequency) {
-        maxFrequency = frequency[x][y];
+    // Blue for rare up to red for the most frequent cell
+    lut.resize(LUT_SIZE);
+    for (int i = 0; i < LUT_SIZE; ++i) {
+        float ratio = float(i) / (LUT_SIZE - 1);
+        lut[i] = QColor::fromHsvF(0.6 - ratio * 0.6, 1.0, 1.0).rgba();
     }
-    update();
+
+    // Points arrive far faster than the screen refreshes
+    repaintTimer = new QTimer(this);
+    repaintTimer->setSingleShot(true);
+    repaintTimer->setInterval(16);
+    connect(repaintTimer, &QTimer::timeout, this, &Fake3DChart::flush);
 }
 
-void Fake3DChart::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    int cellWidth = width() / MAX_X;
-    int cellHeight = height() / MAX_Y;
-
-    for (int x = 0; x < MAX_X; ++x) {
-        for (int y = 0; y < MAX_Y; ++y) {
-            int freq = frequency[x][y];
-            if (freq > 0) {
-                float ratio = float(freq) / maxFrequency;
-                QColor color = QColor::fromHsvF(0.6 - ratio * 0.6, 1.0, 1.0);
-                painter.fillRect(x * cellWidth, height() - (y + 1) * cellHeight, cellWidth, cellHeight, color);
-            }
+void Fake3DChart::addDataPoint(double x, double y) {
+    hist.add(x, y);
+    histogramChanged();
+}
+
+void Fake3DChart::addDataPoints(const double *x, const double *y, qsizetype count) {
+    hist.add(x, y, count);
+    histogramChanged();
+}
+
+void Fake3DChart::advanceTime(double seconds) {
+    hist.advanceTime(seconds);
+    histogramChanged();
+}
+
+void Fake3DChart::histogramChanged() {
+    if (!repaintTimer->isActive())
+        repaintTimer->start();
+}
+
+QSize Fake3DChart::imageSize() const {
+    // One pixel per bin, but never more pixels than the widget shows
+    return QSize(qMin(hist.binsX(), qMax(1, width())), qMin(hist.binsY(), qMax(1, height())));
+}
+
+void Fake3DChart::colorBin(int x, int y, double count) {
+    // Between full passes counts only grow, so a pixel keeps the highest
+    // level of the bins it covers
+    const double maxCount = hist.maxCount();
+    if (count <= 0 || maxCount <= 0)
+        return;
+    const int px = int(qint64(x) * cells.width() / hist.binsX());
+    const int py = cells.height() - 1 - int(qint64(y) * cells.height() / hist.binsY());
+    float &level = levels[size_t(py) * size_t(cells.width()) + size_t(px)];
+    const float ratio = float(count / maxCount);
+    if (ratio <= level)
+        return;
+    level = ratio;
+    reinterpret_cast<QRgb *>(cells.scanLine(py))[px] = lut[qBound(0, int(ratio * (LUT_SIZE - 1)), LUT_SIZE - 1)];
+}
+
+void Fake3DChart::flush() {
+    TraceScope trace("Fake3DChart::flush");
+    const QRect dirtyBins = hist.takeDirty();
+    const QSize size = imageSize();
+    const bool resized = cells.size() != size;
+    if (resized)
+        cells = QImage(size, QImage::Format_ARGB32_Premultiplied);
+
+    // Rebinning, aging or a new maximum changes every cell's colour: one
+    // pass. Decay alone scales every count and the maximum alike, so it
+    // changes no colour.
+    if (resized || hist.generation() != paintedGeneration || hist.maxStoredCount() != paintedMax
+        || qint64(dirtyBins.width()) * dirtyBins.height() > MaxPartialBins) {
+        cells.fill(Qt::transparent);
+        levels.assign(size_t(size.width()) * size_t(size.height()), 0.0f);
+        hist.forEachCell([this](int x, int y, double count) { colorBin(x, y, count); });
+        paintedGeneration = hist.generation();
+        paintedMax = hist.maxStoredCount();
+        update();
+        return;
+    }
+
+    if (!dirtyBins.isEmpty()) {
+        for (int y = dirtyBins.top(); y <= dirtyBins.bottom(); ++y) {
+            for (int x = dirtyBins.left(); x <= dirtyBins.right(); ++x)
+                colorBin(x, y, hist.count(x, y));
         }
+        update(widgetRect(dirtyBins));
     }
 }
+
+QRect Fake3DChart::widgetRect(const QRect &bins) const {
+    // Rounded outwards; bin rows count up from the bottom of the widget
+    const int left = int(qint64(bins.left()) * width() / hist.binsX());
+    const int right = int((qint64(bins.right() + 1) * width() + hist.binsX() - 1) / hist.binsX());
+    const int top = height() - int((qint64(bins.bottom() + 1) * height() + hist.binsY() - 1) / hist.binsY());
+    const int bottom = height() - int(qint64(bins.top()) * height() / hist.binsY());
+    return QRect(left, top, right - left, bottom - top);
+}
+
+void Fake3DChart::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    // The image follows the widget size when there are more bins than pixels
+    if (imageSize() != cells.size())
+        histogramChanged();
+}
+
+qint64 Fake3DChart::takePaintNs() {
+    const qint64 ns = paintNs;
+    paintNs = 0;
+    return ns;
+}
+
+void Fake3DChart::paintEvent(QPaintEvent *event) {
+    QElapsedTimer timer;
+    timer.start();
+    QPainter painter(this);
+    painter.setClipRect(event->rect());
+
+    // Nearest-neighbour scaling keeps every bin a solid block
+    painter.drawImage(rect(), cells);
+    painter.end();
+    paintNs += timer.nsecsElapsed();
+}
@@ -1,26 +1,62 @@
 #ifndef FAKE3DCHART_H
 #define FAKE3DCHART_H
 
+#include <QImage>
+#include <QTimer>
+#include <QVector>
 #include <QWidget>
 #include <vector>
 
+#include "histogram2d.h"
+
+// Heatmap of how often each (x, y) pair was seen, backed by a Histogram2D.
+// Counts are mirrored into an image with one pixel per bin, coloured
+// through a lookup table, so a new point only touches its own pixel;
+// repaints are coalesced and limited to the bins that changed since the
+// last one. A grid with more bins than the widget has pixels is reduced to
+// the widget size, each pixel showing the highest count of its bins.
 class Fake3DChart : public QWidget {
     Q_OBJECT
 
 public:
     explicit Fake3DChart(QWidget *parent = nullptr);
 
-    void addDataPoint(int x, int y);  // Accept X and Y, count frequency for Z
+    void addDataPoint(double x, double y);  // Accept X and Y, count frequency for Z
+    void addDataPoints(const double *x, const double *y, qsizetype count);
+
+    // Ages the counts when the histogram decays or uses a window
+    void advanceTime(double seconds);
+
+    // Call histogramChanged() after reconfiguring the histogram
+    Histogram2D &histogram() { return hist; }
+    void histogramChanged();
+
+    // Brings the image up to date now rather than on the repaint timer,
+    // e.g. before rendering the widget offscreen
+    void flush();
+
+    // Time spent in paintEvent() since the last call
+    qint64 takePaintNs();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
-    static const int MAX_X = 100;
-    static const int MAX_Y = 100;
-
-    int frequency[MAX_X][MAX_Y] = {{0}};
-    int maxFrequency = 1;
+    static const int LUT_SIZE = 256;
+
+    QSize imageSize() const;
+    QRect widgetRect(const QRect &bins) const;
+    void colorBin(int x, int y, double count);
+
+    Histogram2D hist;
+    QImage cells;                    // top row is the highest y bin
+    std::vector<float> levels;       // count / maxCount shown by each pixel of `cells`
+    QVector<QRgb> lut;               // colour by count * (LUT_SIZE - 1) / maxCount
+    quint64 paintedGeneration = 0;   // histogram generation the image reflects
+    double paintedMax = 0;           // maxStoredCount() the image reflects
+    qint64 paintNs = 0;
+    QTimer *repaintTimer;
 };
 
 #endif // FAKE3DCHART_H
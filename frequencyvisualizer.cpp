@@ -1,46 +1,108 @@
 #include "frequencyvisualizer.h"
 #include <QPainter>
-#include <QLinearGradient>
-#include <QDebug>
+#include <algorithm>
 
 FrequencyVisualizer::FrequencyVisualizer(QWidget *parent)
     : QWidget(parent) {
     setMinimumSize(300, 300);
+
+    // Blue for rare up to red for the most frequent cell
+    lut.resize(LUT_SIZE);
+    for (int i = 0; i < LUT_SIZE; ++i) {
+        float ratio = float(i) / (LUT_SIZE - 1);
+        lut[i] = QColor::fromHsvF(0.6 - ratio * 0.6, 1.0, 1.0).rgb();
+    }
 }
 
-void FrequencyVisualizer::setData(const std::vector<std::vector<int>> &data) {
-    frequencyGrid = data;
+void FrequencyVisualizer::setData(std::vector<int> &&values, int rows, int columns) {
+    gridRows = qMax(0, rows);
+    gridColumns = qMax(0, columns);
+    grid = std::move(values);
+    grid.resize(size_t(gridRows) * size_t(gridColumns));
+    gridReplaced();
+}
 
-    maxFrequency = 1;
-    for (const auto &row : data) {
-        for (int val : row) {
-            if (val > maxFrequency) maxFrequency = val;
-        }
-    }
+void FrequencyVisualizer::setData(const int *values, int rows, int columns) {
+    gridRows = qMax(0, rows);
+    gridColumns = qMax(0, columns);
+    grid.assign(values, values + size_t(gridRows) * size_t(gridColumns));
+    gridReplaced();
+}
 
+void FrequencyVisualizer::gridReplaced() {
+    if (cells.width() != gridColumns || cells.height() != gridRows)
+        cells = gridRows > 0 && gridColumns > 0 ? QImage(gridColumns, gridRows, QImage::Format_RGB32) : QImage();
+    rescanMax();
+    dirty = QRect(0, 0, gridColumns, gridRows);
+    paintedMax = 0;
     update();
 }
 
-void FrequencyVisualizer::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+void FrequencyVisualizer::updateCells(int row, int column, int rows, int columns,
+                                      const int *values, qsizetype stride) {
+    // Clip the block to the grid
+    const QRect area = QRect(column, row, columns, rows) & QRect(0, 0, gridColumns, gridRows);
+    if (area.isEmpty()) return;
+    values += qsizetype(area.top() - row) * stride + (area.left() - column);
 
-    int rows = frequencyGrid.size();
-    if (rows == 0) return;
+    for (int y = area.top(); y <= area.bottom(); ++y, values += stride) {
+        int *line = grid.data() + size_t(y) * size_t(gridColumns);
+        for (int x = 0; x < area.width(); ++x)
+            storeCell(line[area.left() + x], values[x]);
+    }
+    dirty |= area;
+    update();
+}
 
-    int cols = frequencyGrid[0].size();
-    if (cols == 0) return;
+void FrequencyVisualizer::setCell(int row, int column, int value) {
+    updateCells(row, column, 1, 1, &value, 1);
+}
 
-    float cellW = width() / float(cols);
-    float cellH = height() / float(rows);
+void FrequencyVisualizer::storeCell(int &cell, int value) {
+    if (value > maxFrequency) {
+        maxFrequency = value;
+        cellsAtMax = 1;
+    } else if (value == maxFrequency && cell != maxFrequency) {
+        ++cellsAtMax;
+    } else if (cell == maxFrequency && value < maxFrequency && --cellsAtMax == 0) {
+        maxStale = true;
+    }
+    cell = value;
+}
+
+void FrequencyVisualizer::rescanMax() {
+    // At least 1, so an all-zero grid is drawn blue
+    maxFrequency = qMax(1, grid.empty() ? 1 : *std::max_element(grid.begin(), grid.end()));
+    cellsAtMax = std::count(grid.begin(), grid.end(), maxFrequency);
+    maxStale = false;
+}
 
-    for (int x = 0; x < rows; ++x) {
-        for (int y = 0; y < cols; ++y) {
-            float intensity = frequencyGrid[x][y] / float(maxFrequency);
-            QColor color = QColor::fromHsvF(0.6 - intensity * 0.6, 1.0, 1.0);
-            painter.setBrush(color);
-            painter.setPen(Qt::NoPen);
-            painter.drawRect(y * cellW, x * cellH, cellW, cellH);
+void FrequencyVisualizer::colorCells(const QRect &area) {
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        const int *line = grid.data() + size_t(y) * size_t(gridColumns);
+        QRgb *pixels = reinterpret_cast<QRgb *>(cells.scanLine(y));
+        for (int x = area.left(); x <= area.right(); ++x) {
+            const int index = int(qint64(qMax(0, line[x])) * (LUT_SIZE - 1) / maxFrequency);
+            pixels[x] = lut[qMin(index, LUT_SIZE - 1)];
         }
     }
 }
+
+void FrequencyVisualizer::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    if (cells.isNull()) return;
+
+    // A new maximum changes every cell's colour, otherwise only the changed ones
+    if (maxStale)
+        rescanMax();
+    if (maxFrequency != paintedMax) {
+        colorCells(cells.rect());
+        paintedMax = maxFrequency;
+    } else if (!dirty.isEmpty()) {
+        colorCells(dirty);
+    }
+    dirty = QRect();
+
+    // Nearest-neighbour scaling keeps every cell a solid block
+    painter.drawImage(rect(), cells);
+}
@@ -1,23 +1,60 @@
 #ifndef FREQUENCYVISUALIZER_H
 #define FREQUENCYVISUALIZER_H
 
+#include <QImage>
+#include <QVector>
 #include <QWidget>
 #include <vector>
 
+// Heatmap of a grid of counts. The grid is one contiguous row-major buffer
+// that can be moved in or patched in place; the maximum is kept up to date
+// as cells change. Each cell is one pixel of a backing image, coloured
+// through a lookup table when the widget repaints, and the image is scaled
+// to the widget in a single drawImage().
 class FrequencyVisualizer : public QWidget {
     Q_OBJECT
 
 public:
     explicit FrequencyVisualizer(QWidget *parent = nullptr);
 
-    void setData(const std::vector<std::vector<int>> &data);
+    // Replaces the grid; values holds rows * columns counts, row by row
+    void setData(std::vector<int> &&values, int rows, int columns);
+    void setData(const int *values, int rows, int columns);
+
+    // Overwrites the block at (row, column); values holds `rows` lines of
+    // `columns` counts that start `stride` values apart
+    void updateCells(int row, int column, int rows, int columns, const int *values, qsizetype stride);
+    void setCell(int row, int column, int value);
+
+    int rows() const { return gridRows; }
+    int columns() const { return gridColumns; }
+    const int *data() const { return grid.data(); }
 
 protected:
     void paintEvent(QPaintEvent *event) override;
 
 private:
-    std::vector<std::vector<int>> frequencyGrid;
+    static const int LUT_SIZE = 256;
+
+    void gridReplaced();
+    void storeCell(int &cell, int value);
+    void rescanMax();
+    void colorCells(const QRect &area);
+
+    std::vector<int> grid;
+    int gridRows = 0;
+    int gridColumns = 0;
+
+    // Cells equal to the maximum; when the last of them drops, the maximum
+    // is rescanned before the next paint
     int maxFrequency = 1;
+    qsizetype cellsAtMax = 0;
+    bool maxStale = false;
+
+    QImage cells;           // one pixel per cell
+    QVector<QRgb> lut;      // colour by count * (LUT_SIZE - 1) / maxFrequency
+    QRect dirty;            // cells changed since the last paint
+    int paintedMax = 0;
 };
 
 #endif // FREQUENCYVISUALIZER_H
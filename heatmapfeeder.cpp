@@ -0,0 +1,68 @@
+#include "heatmapfeeder.h"
+#include <cmath>
+
+void HeatmapFeeder::setMode(Mode mode) {
+    pairMode = mode;
+    haveX = haveY = false;
+}
+
+void HeatmapFeeder::setChannels(int keyX, int keyY) {
+    channelX = keyX;
+    channelY = keyY;
+    haveX = haveY = false;
+}
+
+void HeatmapFeeder::collect(const QVector<Sample> &batch, int channelsPerDevice) {
+    pointsX.clear();
+    pointsY.clear();
+    auto emitPoint = [this](double x, double y) {
+        pointsX.push_back(x);
+        pointsY.push_back(y);
+    };
+
+    for (const Sample &sample : batch) {
+        const int key = sample.device * channelsPerDevice + sample.channel;
+        if (pairMode == Mode::ValueDelta) {
+            if (key != channelX) continue;
+            if (haveX)
+                emitPoint(sample.value, sample.value - lastX);
+            lastX = sample.value;
+            haveX = true;
+        } else if (key == channelX) {
+            lastX = sample.value;
+            haveX = true;
+            if (haveY) emitPoint(lastX, lastY);
+        } else if (key == channelY) {
+            lastY = sample.value;
+            haveY = true;
+            if (haveX) emitPoint(lastX, lastY);
+        }
+    }
+
+    // Pairing and redrawing have to happen anyway; when inserting all points
+    // would not fit in what they leave of the budget, only every
+    // keepEvery-th one is handed to the heatmap. A tenth of the budget is
+    // always left for inserting, so the heatmap keeps moving.
+    const size_t count = pointsX.size();
+    const double expected = double(count) * nsPerPoint;
+    const double available = qMax(double(budgetNs) - otherNs, double(budgetNs) / 10);
+    keepEvery = qMax(1, int(std::ceil(expected / available)));
+    if (keepEvery > 1) {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i += size_t(keepEvery), ++kept) {
+            pointsX[kept] = pointsX[i];
+            pointsY[kept] = pointsY[i];
+        }
+        pointsX.resize(kept);
+        pointsY.resize(kept);
+        skipped += count - kept;
+    }
+    fed += pointsX.size();
+}
+
+void HeatmapFeeder::recordCost(qint64 insertNs, qint64 otherNs) {
+    this->otherNs = this->otherNs * 0.8 + double(otherNs) * 0.2;
+    if (pointsX.empty()) return;
+    const double sample = double(insertNs) / double(pointsX.size());
+    nsPerPoint = nsPerPoint * 0.8 + sample * 0.2;
+}
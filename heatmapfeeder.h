@@ -0,0 +1,64 @@
+#ifndef HEATMAPFEEDER_H
+#define HEATMAPFEEDER_H
+
+#include <QVector>
+#include <vector>
+
+#include "samplering.h"
+
+// Turns each frame's sample batch into (x, y) points for the heatmap:
+// either one channel's value against its change since the previous sample,
+// or the latest value of channel X against channel Y. The heatmap's share of
+// a frame (pairing, inserting, redrawing and painting) is measured, and
+// when a batch would exceed the per-frame budget only every n-th point is
+// inserted, so the visualizer never takes more than a fixed slice of the
+// GUI thread.
+class HeatmapFeeder {
+public:
+    enum class Mode { ValueDelta, ChannelPair };
+
+    void setMode(Mode mode);
+    Mode mode() const { return pairMode; }
+
+    // Trace keys (device * channelsPerDevice + channel); Y is unused for ValueDelta
+    void setChannels(int keyX, int keyY);
+    void setBudgetNs(qint64 ns) { budgetNs = qMax<qint64>(1000, ns); }
+
+    // Collects the points of one batch into xs()/ys()
+    void collect(const QVector<Sample> &batch, int channelsPerDevice);
+    const std::vector<double> &xs() const { return pointsX; }
+    const std::vector<double> &ys() const { return pointsY; }
+
+    // Time the heatmap took to insert the collected points, and the rest of
+    // the frame's heatmap work (pairing, redrawing, painting); refines the
+    // estimates the next batch is thinned with
+    void recordCost(qint64 insertNs, qint64 otherNs);
+
+    int stride() const { return keepEvery; }
+    double costNsPerPoint() const { return nsPerPoint; }
+    double overheadNs() const { return otherNs; }
+    quint64 pointsFed() const { return fed; }
+    quint64 pointsSkipped() const { return skipped; }
+
+private:
+    Mode pairMode = Mode::ValueDelta;
+    int channelX = 0;
+    int channelY = 1;
+    qint64 budgetNs = 1000000;
+
+    // Pairing state carried across batches
+    bool haveX = false;
+    bool haveY = false;
+    double lastX = 0;
+    double lastY = 0;
+
+    std::vector<double> pointsX;
+    std::vector<double> pointsY;
+    double nsPerPoint = 100;       // running estimates, refined by recordCost()
+    double otherNs = 0;
+    int keepEvery = 1;
+    quint64 fed = 0;
+    quint64 skipped = 0;
+};
+
+#endif // HEATMAPFEEDER_H
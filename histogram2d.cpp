@@ -0,0 +1,255 @@
+#include "histogram2d.h"
+#include <cmath>
+
+// Doubling more often than this means the point is absurdly far off
+static const int MaxDoublings = 62;
+
+// Bin index after the span doubled `shift` times. Growing to the left keeps
+// the right edge fixed, so bins are counted from there.
+static quint64 mergedBin(quint64 bin, int bins, int shift, bool left) {
+    return left ? quint64(bins - 1) - ((quint64(bins - 1) - bin) >> shift) : bin >> shift;
+}
+
+Histogram2D::Histogram2D(int binsX, int binsY, double xMin, double xMax, double yMin, double yMax)
+    : nx(qMax(1, binsX)), ny(qMax(1, binsY)) {
+    x0 = xMin;
+    dx = (xMax > xMin ? xMax - xMin : 1.0) / nx;
+    y0 = yMin;
+    dy = (yMax > yMin ? yMax - yMin : 1.0) / ny;
+    reset();
+}
+
+void Histogram2D::setBins(int binsX, int binsY) {
+    const double xEnd = xMax();
+    const double yEnd = yMax();
+    nx = qMax(1, binsX);
+    ny = qMax(1, binsY);
+    dx = (xEnd - x0) / nx;
+    dy = (yEnd - y0) / ny;
+    reset();
+}
+
+void Histogram2D::setRange(double xMin, double xMax, double yMin, double yMax) {
+    x0 = xMin;
+    dx = (xMax > xMin ? xMax - xMin : 1.0) / nx;
+    y0 = yMin;
+    dy = (yMax > yMin ? yMax - yMin : 1.0) / ny;
+    reset();
+}
+
+void Histogram2D::setCumulative() {
+    countMode = Mode::Cumulative;
+    slotIncrements.clear();
+    reset();
+}
+
+void Histogram2D::setDecay(double halfLifeSeconds) {
+    countMode = Mode::Decay;
+    halfLife = qMax(1e-6, halfLifeSeconds);
+    slotIncrements.clear();
+    reset();
+}
+
+void Histogram2D::setWindow(double seconds, int slots) {
+    countMode = Mode::Window;
+    slots = qMax(1, slots);
+    slotLength = qMax(1e-6, seconds) / slots;
+    slotIncrements.assign(size_t(slots), Increments());
+    reset();
+}
+
+void Histogram2D::clear() {
+    reset();
+}
+
+void Histogram2D::reset() {
+    sparse = qint64(nx) * ny > SparseThreshold;
+    dense.assign(sparse ? 0 : size_t(nx) * size_t(ny), 0.0);
+    cells.clear();
+    maxStored = 0;
+    scale = 1;
+    for (Increments &slot : slotIncrements)
+        slot.clear();
+    slotElapsed = 0;
+    currentSlot = 0;
+    dirty = QRect();
+    ++gen;
+}
+
+void Histogram2D::add(double x, double y) {
+    if (!std::isfinite(x) || !std::isfinite(y) || !fit(x, y)) {
+        ++dropped;
+        return;
+    }
+
+    const int ix = qBound(0, int((x - x0) / dx), nx - 1);
+    const int iy = qBound(0, int((y - y0) / dy), ny - 1);
+    const quint64 cell = quint64(iy) * quint64(nx) + quint64(ix);
+    increment(cell, 1.0 / scale);
+    if (countMode == Mode::Window)
+        slotIncrements[currentSlot][cell] += 1.0;
+    dirty |= QRect(ix, iy, 1, 1);
+}
+
+void Histogram2D::add(const double *x, const double *y, qsizetype count) {
+    for (qsizetype i = 0; i < count; ++i)
+        add(x[i], y[i]);
+}
+
+bool Histogram2D::fit(double x, double y) {
+    const bool inX = x >= x0 && x < xMax();
+    const bool inY = y >= y0 && y < yMax();
+    if (inX && inY)
+        return true;
+    if (!autoRange)
+        return false;
+
+    // Double the span towards the point until it fits
+    int shiftX = 0, shiftY = 0;
+    double lo = x0, hi = xMax();
+    for (; x < lo || x >= hi; ++shiftX) {
+        if (shiftX == MaxDoublings) return false;
+        if (x < lo) lo = hi - 2 * (hi - lo);
+        else hi = lo + 2 * (hi - lo);
+    }
+    const bool leftX = lo < x0;
+    lo = y0, hi = yMax();
+    for (; y < lo || y >= hi; ++shiftY) {
+        if (shiftY == MaxDoublings) return false;
+        if (y < lo) lo = hi - 2 * (hi - lo);
+        else hi = lo + 2 * (hi - lo);
+    }
+    const bool leftY = lo < y0;
+
+    rebin(shiftX, shiftY, leftX, leftY);
+    return true;
+}
+
+void Histogram2D::rebin(int shiftX, int shiftY, bool leftX, bool leftY) {
+    if (leftX) x0 = xMax() - std::ldexp(nx * dx, shiftX);
+    dx = std::ldexp(dx, shiftX);
+    if (leftY) y0 = yMax() - std::ldexp(ny * dy, shiftY);
+    dy = std::ldexp(dy, shiftY);
+
+    if (sparse) {
+        remap(cells, shiftX, shiftY, leftX, leftY);
+    } else {
+        std::vector<double> merged(dense.size(), 0.0);
+        for (size_t i = 0; i < dense.size(); ++i) {
+            if (dense[i] != 0)
+                merged[mergedBin(i / size_t(nx), ny, shiftY, leftY) * size_t(nx)
+                       + mergedBin(i % size_t(nx), nx, shiftX, leftX)] += dense[i];
+        }
+        dense.swap(merged);
+    }
+    for (Increments &slot : slotIncrements)
+        remap(slot, shiftX, shiftY, leftX, leftY);
+
+    rescanMax();
+    dirty = QRect();
+    ++gen;
+}
+
+void Histogram2D::remap(Increments &map, int shiftX, int shiftY, bool leftX, bool leftY) const {
+    Increments merged;
+    merged.reserve(map.size());
+    for (const auto &cell : map) {
+        const quint64 ix = mergedBin(cell.first % quint64(nx), nx, shiftX, leftX);
+        const quint64 iy = mergedBin(cell.first / quint64(nx), ny, shiftY, leftY);
+        merged[iy * quint64(nx) + ix] += cell.second;
+    }
+    map.swap(merged);
+}
+
+void Histogram2D::increment(quint64 cell, double amount) {
+    double &stored = sparse ? cells[cell] : dense[size_t(cell)];
+    stored += amount;
+    maxStored = qMax(maxStored, stored);
+}
+
+void Histogram2D::advanceTime(double seconds) {
+    if (seconds <= 0)
+        return;
+
+    if (countMode == Mode::Decay) {
+        // Every count decays by the same factor, so only the scale changes;
+        // stored values are folded back in before they grow too large
+        scale *= std::exp2(-seconds / halfLife);
+        if (scale < 1e-6)
+            applyScale();
+        return;
+    }
+
+    if (countMode == Mode::Window) {
+        slotElapsed += seconds;
+        if (slotElapsed >= slotLength * double(slotIncrements.size())) {
+            reset();
+            return;
+        }
+        bool rotated = false;
+        for (; slotElapsed >= slotLength; slotElapsed -= slotLength) {
+            // The slot after the current one is the oldest; drop its counts
+            currentSlot = (currentSlot + 1) % slotIncrements.size();
+            for (const auto &cell : slotIncrements[currentSlot]) {
+                if (sparse) {
+                    auto it = cells.find(cell.first);
+                    if (it != cells.end() && (it->second -= cell.second) < 0.5)
+                        cells.erase(it);
+                } else {
+                    dense[size_t(cell.first)] -= cell.second;
+                }
+            }
+            slotIncrements[currentSlot].clear();
+            rotated = true;
+        }
+        if (rotated) {
+            rescanMax();
+            dirty = QRect();
+            ++gen;
+        }
+    }
+}
+
+double Histogram2D::count(int ix, int iy) const {
+    if (ix < 0 || ix >= nx || iy < 0 || iy >= ny)
+        return 0;
+    const quint64 cell = quint64(iy) * quint64(nx) + quint64(ix);
+    if (sparse) {
+        auto it = cells.find(cell);
+        return it == cells.end() ? 0 : it->second * scale;
+    }
+    return dense[size_t(cell)] * scale;
+}
+
+QRect Histogram2D::takeDirty() {
+    QRect changed = dirty;
+    dirty = QRect();
+    return changed;
+}
+
+void Histogram2D::rescanMax() {
+    maxStored = 0;
+    if (sparse) {
+        for (const auto &cell : cells)
+            maxStored = qMax(maxStored, cell.second);
+    } else {
+        for (double stored : dense)
+            maxStored = qMax(maxStored, stored);
+    }
+}
+
+void Histogram2D::applyScale() {
+    // Cells that have decayed to nothing are dropped from a sparse grid
+    if (sparse) {
+        for (auto it = cells.begin(); it != cells.end();) {
+            it->second *= scale;
+            it = it->second < 1e-3 ? cells.erase(it) : std::next(it);
+        }
+    } else {
+        for (double &stored : dense)
+            stored *= scale;
+    }
+    maxStored *= scale;
+    scale = 1;
+    ++gen;
+}
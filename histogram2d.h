@@ -0,0 +1,116 @@
+#ifndef HISTOGRAM2D_H
+#define HISTOGRAM2D_H
+
+#include <QRect>
+#include <QtGlobal>
+#include <unordered_map>
+#include <vector>
+
+// 2D histogram of (x, y) pairs over a configurable grid of bins.
+//
+// Points outside the range either grow it (auto range: the span doubles
+// towards the point and neighbouring bins merge, so the bin count stays
+// fixed) or are counted in outOfRange(). Counts can be cumulative, decay
+// exponentially with a half-life, or cover a sliding time window made of
+// `slots` sub-intervals. Grids above SparseThreshold cells keep only the
+// non-empty cells in a hash map.
+class Histogram2D {
+public:
+    enum class Mode { Cumulative, Decay, Window };
+    static constexpr qint64 SparseThreshold = 1 << 22;
+
+    Histogram2D(int binsX = 100, int binsY = 100,
+                double xMin = 0, double xMax = 100, double yMin = 0, double yMax = 100);
+
+    // These clear the counts
+    void setBins(int binsX, int binsY);
+    void setRange(double xMin, double xMax, double yMin, double yMax);
+    void setCumulative();
+    void setDecay(double halfLifeSeconds);
+    void setWindow(double seconds, int slots = 10);
+    void clear();
+
+    void setAutoRange(bool enabled) { autoRange = enabled; }
+    bool isSparse() const { return sparse; }
+    Mode mode() const { return countMode; }
+
+    void add(double x, double y);
+    void add(const double *x, const double *y, qsizetype count);
+
+    // Ages the counts in Decay and Window modes
+    void advanceTime(double seconds);
+
+    int binsX() const { return nx; }
+    int binsY() const { return ny; }
+    double xMin() const { return x0; }
+    double xMax() const { return x0 + nx * dx; }
+    double yMin() const { return y0; }
+    double yMax() const { return y0 + ny * dy; }
+
+    double count(int ix, int iy) const;
+    double maxCount() const { return maxStored * scale; }
+    // maxCount() without the decay scale: count / maxCount() of every cell
+    // stays the same while this does
+    double maxStoredCount() const { return maxStored; }
+    quint64 outOfRange() const { return dropped; }
+
+    // Visits every non-empty cell as f(ix, iy, count)
+    template <typename F>
+    void forEachCell(F &&f) const {
+        if (sparse) {
+            for (const auto &cell : cells)
+                f(int(cell.first % quint64(nx)), int(cell.first / quint64(nx)), cell.second * scale);
+        } else {
+            for (size_t i = 0; i < dense.size(); ++i) {
+                if (dense[i] != 0)
+                    f(int(i % size_t(nx)), int(i / size_t(nx)), dense[i] * scale);
+            }
+        }
+    }
+
+    // Bumped whenever any cell may have changed other than through add():
+    // rebinning, decay, window rotation, reconfiguration
+    quint64 generation() const { return gen; }
+
+    // Bounding box (in bins) of the cells add() touched since the last call
+    QRect takeDirty();
+
+private:
+    using Increments = std::unordered_map<quint64, double>;
+
+    void reset();
+    bool fit(double x, double y);
+    void rebin(int shiftX, int shiftY, bool leftX, bool leftY);
+    void remap(Increments &map, int shiftX, int shiftY, bool leftX, bool leftY) const;
+    void increment(quint64 cell, double amount);
+    void rescanMax();
+    void applyScale();
+
+    int nx;
+    int ny;
+    double x0, dx;
+    double y0, dy;
+    bool autoRange = true;
+    bool sparse = false;
+
+    std::vector<double> dense;
+    Increments cells;
+    double maxStored = 0;
+    quint64 dropped = 0;
+
+    // Decay: stored counts are divided by `scale`, so aging is O(1)
+    Mode countMode = Mode::Cumulative;
+    double halfLife = 0;
+    double scale = 1;
+
+    // Window: per-slot increments, subtracted when a slot leaves the window
+    std::vector<Increments> slotIncrements;
+    double slotLength = 0;
+    double slotElapsed = 0;
+    size_t currentSlot = 0;
+
+    quint64 gen = 0;
+    QRect dirty;
+};
+
+#endif // HISTOGRAM2D_H
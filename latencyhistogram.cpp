@@ -0,0 +1,64 @@
+#include "latencyhistogram.h"
+#include <QtAlgorithms>
+#include <cmath>
+
+static const int SubBuckets = 1 << LatencyHistogram::SubBucketBits;
+
+LatencyHistogram::LatencyHistogram()
+    : counts(size_t(bucketOf(MaxValue - 1)) + 1, 0) {}
+
+int LatencyHistogram::bucketOf(qint64 ns) {
+    // Values below SubBuckets are exact; above, each power of two gets
+    // SubBuckets buckets of equal width
+    const quint64 value = quint64(ns);
+    if (value < quint64(SubBuckets))
+        return int(value);
+    const int exponent = 63 - int(qCountLeadingZeroBits(value));
+    const int shift = exponent - LatencyHistogram::SubBucketBits;
+    return (shift + 1) * SubBuckets + int(value >> shift) - SubBuckets;
+}
+
+qint64 LatencyHistogram::lowestIn(int bucket) {
+    if (bucket < SubBuckets)
+        return bucket;
+    const int shift = bucket / SubBuckets - 1;
+    return qint64(SubBuckets + bucket % SubBuckets) << shift;
+}
+
+void LatencyHistogram::record(qint64 ns) {
+    ns = qBound<qint64>(0, ns, MaxValue - 1);
+    ++counts[size_t(bucketOf(ns))];
+    minimum = total ? qMin(minimum, ns) : ns;
+    maximum = qMax(maximum, ns);
+    sum += double(ns);
+    ++total;
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other) {
+    if (other.total == 0) return;
+    for (size_t i = 0; i < counts.size(); ++i)
+        counts[i] += other.counts[i];
+    minimum = total ? qMin(minimum, other.minimum) : other.minimum;
+    maximum = qMax(maximum, other.maximum);
+    sum += other.sum;
+    total += other.total;
+}
+
+void LatencyHistogram::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    minimum = maximum = 0;
+    sum = 0;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const {
+    if (total == 0) return 0;
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(qBound(0.0, percent, 100.0) / 100.0 * double(total))));
+    quint64 seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return qMin(maximum, lowestIn(int(i) + 1) - 1);
+    }
+    return maximum;
+}
@@ -0,0 +1,50 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <vector>
+
+// HDR-style histogram of latencies in nanoseconds: every power of two is
+// split into 128 linear buckets, so any recorded value is known to within
+// 1% over the whole range (up to MaxValue) in a fixed ~35 KB. Recording is a
+// few instructions and never allocates.
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 7;
+    static constexpr qint64 MaxValue = qint64(1) << 40;   // ~18 minutes
+
+    LatencyHistogram();
+
+    void record(qint64 ns);
+    void add(const LatencyHistogram &other);
+    void clear();
+
+    quint64 count() const { return total; }
+    qint64 min() const { return total ? minimum : 0; }
+    qint64 max() const { return maximum; }
+    double mean() const { return total ? sum / double(total) : 0.0; }
+
+    // Smallest value that at least `percent` % of the recorded values do not exceed
+    qint64 percentile(double percent) const;
+
+    // Visits every non-empty bucket as f(lowestValue, highestValue, count)
+    template <typename F>
+    void forEachBucket(F &&f) const {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] != 0)
+                f(lowestIn(int(i)), lowestIn(int(i) + 1) - 1, counts[i]);
+        }
+    }
+
+private:
+    static int bucketOf(qint64 ns);
+    static qint64 lowestIn(int bucket);
+
+    std::vector<quint64> counts;
+    quint64 total = 0;
+    qint64 minimum = 0;
+    qint64 maximum = 0;
+    double sum = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -1,8 +1,18 @@
 #include "mainwindow.h"
+#include "batchrender.h"
+#include "devicesimulator.h"
 #include <QApplication>
 
 int main(int argc, char *argv[]) {
+    // Headless modes never create the QApplication or any window
+    if (isBatchRenderInvocation(argc, argv))
+        return runBatchRender(argc, argv);
+    if (isSimulatorInvocation(argc, argv))
+        return runSimulator(argc, argv);
+
     QApplication a(argc, argv);
+    QApplication::setOrganizationName("SerialDataVisualizer");
+    QApplication::setApplicationName("MenuBar");
     MainWindow w;
     w.resize(1200, 800);
     w.show();
@@ -1,6 +1,8 @@
 // mainwindow.cpp
 #include "mainwindow.h"
 #include "portdialog.h"
+#include "simulatordialog.h"
+#include "tracing.h"
 #include <QMenuBar>
 #include <QToolBar>
 #include <QLabel>
@@ -12,11 +14,22 @@
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QChart>
 #include <QFileDialog>
-#include <QPdfWriter>
 #include <QPainter>
-#include <QPageSize>
 #include <QApplication>
 #include <QStyle>
+#include <QSettings>
+#include <QInputDialog>
+#include <QHeaderView>
+#include <QStatusBar>
+#include <QWheelEvent>
+#include <QKeyEvent>
+#include <QProgressDialog>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <limits>
 
 
 
@@ -39,75 +52,670 @@ MainWindow::MainWindow(QWidget *parent)
     centralLayout->addWidget(taskBarWidget);
     setCentralWidget(central);
 
-    serial = new QSerialPort(this);
-    connect(serial, &QSerialPort::readyRead, this, [this]() {
-        while (serial->canReadLine()) {
-            QByteArray line = serial->readLine().trimmed();
-            bool ok;
-            double value = line.toDouble(&ok);
-            if (ok && series) {
-                series->append(dataPointIndex++, value);
-
-                // Add to rolling history
-                yValueHistory.enqueue(value);
-                if (yValueHistory.size() > maxHistorySize)
-                    yValueHistory.dequeue();
-
-                // Auto-expand Y
-                if (value > maxYValue) {
-                    maxYValue = value + 1;
-                    chart->axisY()->setRange(0, maxYValue);
-                }
-
-                // Auto-scroll X
-                if (dataPointIndex > 100) {
-                    chart->scroll(chart->plotArea().width()/100, 0);
-                    chart->axisX()->setRange(dataPointIndex - 100, dataPointIndex);
-                }
-
-                lastReceivedValue = value;
-                lastUpdateTime = QDateTime::currentDateTime();
-
-                if (statusLabel) {
-                    statusLabel->setText(
-                        QString("Status: Connected\n"
-                                "Port: %1\n"
-                                "Last Value: %2\n"
-                                "Last Updated: %3")
-                            .arg(currentPortName.isEmpty() ? "N/A" : currentPortName)
-                            .arg(lastReceivedValue)
-                            .arg(lastUpdateTime.toString("hh:mm:ss")));
-                }
-
-            }
-        }
-    });
-
+    recorderThread = new QThread(this);
+    recorderThread->setObjectName("Capture Writer");
+    recorder = new CaptureWriter;
+    recorder->moveToThread(recorderThread);
+    connect(recorderThread, &QThread::finished, recorder, &QObject::deleteLater);
+    recorderThread->start();
+
+    QSettings settings;
+    retentionSamples = settings.value("dataView/retentionSamples", 250000).toLongLong();
+    yRange.setWindow(settings.value("dataView/yRangeWindow", 100).toInt());
+
+    // Samples are applied to the chart once per frame, not once per line
+    renderScheduler = new RenderScheduler(this);
+    renderScheduler->setFrameRate(settings.value("render/frameRate", 60).toInt());
+    connect(renderScheduler, &RenderScheduler::frameReady, this, &MainWindow::renderFrame);
+    // Connected second, so it runs once renderFrame has applied the frame
+    connect(renderScheduler, &RenderScheduler::frameReady, this, &MainWindow::recordLatency);
+    renderScheduler->start();
 
     shrinkTimer = new QTimer(this);
     shrinkTimer->setInterval(1000);  // check every 1 second
     connect(shrinkTimer, &QTimer::timeout, this, &MainWindow::checkAutoShrinkYAxis);
     shrinkTimer->start();
 
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(1000);
+    connect(statusTimer, &QTimer::timeout, this, &MainWindow::refreshDeviceStatus);
+    connect(statusTimer, &QTimer::timeout, this, &MainWindow::refreshHeatmapStatus);
+    statusTimer->start();
+
+    // Builds the block index of an opened capture in small slices
+    indexTimer = new QTimer(this);
+    indexTimer->setInterval(10);
+    connect(indexTimer, &QTimer::timeout, this, &MainWindow::indexPlayback);
+
     setupMenuBar();
     setupToolBar();
     setupTaskBar();
     createPositionedSubWindows();
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    for (const auto &session : sessions)
+        closeSession(*session);
 
+    QMetaObject::invokeMethod(recorder, &CaptureWriter::stop, Qt::BlockingQueuedConnection);
+    recorderThread->quit();
+    recorderThread->wait();
+}
 
-void MainWindow::checkAutoShrinkYAxis() {
-    if (yValueHistory.isEmpty()) return;
+void MainWindow::renderFrame(const QVector<Sample> &batch) {
+    TraceScope trace("MainWindow::renderFrame");
+
+    if (!chart) return;
+    update3DVisualizer(batch);
+
+    const bool rasterActive = dataViewStack->currentWidget() == rasterPlot;
+    double batchMin = minYValue;
+    double batchMax = maxYValue;
+    for (const Sample &sample : batch) {
+        ChannelTrace *trace = traceFor(sample.device, sample.channel);
+        if (!trace) continue;
+        trace->history.append(sample);
+        trace->decimation.append(sample.value);
+        trace->lastValue = sample.value;
+        yRange.add(sample.value);
+        if (rasterActive)
+            rasterPlot->append(trace->plotTrace, float(sample.value));
+
+        batchMin = qMin(batchMin, sample.value);
+        batchMax = qMax(batchMax, sample.value);
+    }
+
+    // Auto-expand Y (a capture being played back manages its own range)
+    if (!playback && (batchMax > maxYValue || batchMin < minYValue)) {
+        if (batchMax > maxYValue) maxYValue = batchMax + 1;
+        if (batchMin < minYValue) minYValue = batchMin - 1;
+        chart->axisY()->setRange(minYValue, maxYValue);
+        rasterPlot->setYRange(minYValue, maxYValue);
+    }
+
+    // The raster plot always follows the live edge and skips the chart entirely
+    if (rasterActive) {
+        rasterPlot->update();
+        return;
+    }
+
+    // Auto-scroll X unless the user has zoomed or panned away from the live edge
+    if (followLive) {
+        alignDevices();
+        viewEnd = qMax(visibleSpan, liveEnd());
+        refreshVisibleSeries();
+    }
+}
+
+void MainWindow::update3DVisualizer(const QVector<Sample> &batch) {
+    TraceScope trace("MainWindow::update3DVisualizer");
+    // Nothing to pay for while the window is minimized or hidden
+    if (!heatmap || !heatmap->isVisible()) {
+        heatmapClock.invalidate();
+        return;
+    }
+
+    // Pairing, inserting, redrawing and the last paint all count against the budget
+    QElapsedTimer timer;
+    timer.start();
+    heatmapFeeder.collect(batch, maxChannels);
+    const qint64 collected = timer.nsecsElapsed();
+    const std::vector<double> &xs = heatmapFeeder.xs();
+    heatmap->addDataPoints(xs.data(), heatmapFeeder.ys().data(), qsizetype(xs.size()));
+    const qint64 insertNs = timer.nsecsElapsed() - collected;
+
+    // Decaying and windowed counts age with wall-clock time
+    if (heatmapClock.isValid())
+        heatmap->advanceTime(heatmapClock.restart() / 1000.0);
+    else
+        heatmapClock.start();
+
+    // Redrawn here rather than on the chart's repaint timer, so it is timed
+    heatmap->flush();
+    const qint64 totalNs = timer.nsecsElapsed() + heatmap->takePaintNs();
+    heatmapFeeder.recordCost(insertNs, totalNs - insertNs);
+    heatmapCostNs += totalNs;
+}
+
+void MainWindow::configureHeatmap() {
+    if (!heatmap) return;
+
+    const bool pairs = heatmapMode->currentIndex() == 1;
+    heatmapY->setEnabled(pairs);
+    heatmapFeeder.setMode(pairs ? HeatmapFeeder::Mode::ChannelPair : HeatmapFeeder::Mode::ValueDelta);
+    heatmapFeeder.setChannels(heatmapX->currentData().toInt(), heatmapY->currentData().toInt());
+
+    // Switching the count mode also clears the histogram
+    Histogram2D &histogram = heatmap->histogram();
+    switch (heatmapCounts->currentIndex()) {
+    case 1: histogram.setDecay(10); break;
+    case 2: histogram.setWindow(30); break;
+    default: histogram.setCumulative(); break;
+    }
+    heatmap->histogramChanged();
+    heatmapClock.invalidate();
+}
+
+void MainWindow::refreshHeatmapStatus() {
+    if (!heatmapStatus) return;
+
+    // Called once a second by statusTimer
+    const quint64 fed = heatmapFeeder.pointsFed() - heatmapReportedFed;
+    const quint64 skipped = heatmapFeeder.pointsSkipped() - heatmapReportedSkipped;
+    heatmapReportedFed = heatmapFeeder.pointsFed();
+    heatmapReportedSkipped = heatmapFeeder.pointsSkipped();
+    QString text = QString("%1 points/s, %2 ms/s").arg(fed).arg(heatmapCostNs / 1e6, 0, 'f', 1);
+    if (skipped > 0)
+        text += QString(", thinned 1 in %1 to stay within budget").arg(heatmapFeeder.stride());
+    heatmapStatus->setText(text);
+    heatmapCostNs = 0;
+}
+
+int MainWindow::deviceIdFor(const QString &portName) {
+    int device = deviceNames.indexOf(portName);
+    if (device < 0) {
+        deviceNames.append(portName);
+        device = deviceNames.size() - 1;
+    }
+    return device;
+}
+
+void MainWindow::closeSession(PortSession &session) {
+    QMetaObject::invokeMethod(session.reader, &SerialReader::closePort, Qt::BlockingQueuedConnection);
+    session.thread->quit();
+    session.thread->wait();
+    session.thread->deleteLater();
+
+    // The reader thread has stopped, so nothing writes to the rings any more
+    renderScheduler->removeSource(session.device);
+    const int device = session.device;
+    QMetaObject::invokeMethod(recorder, [this, device]() {
+        recorder->removeSource(device);
+    }, Qt::BlockingQueuedConnection);
+    session.simulator.reset();
+}
+
+void MainWindow::attachRecorder(PortSession &session, bool attach) {
+    // The writer learns about the ring before the reader starts filling it
+    SampleRing<Sample> *ring = &session.recordRing;
+    const int device = session.device;
+    if (attach) {
+        QMetaObject::invokeMethod(recorder, [this, device, ring]() {
+            recorder->addSource(device, ring);
+        }, Qt::BlockingQueuedConnection);
+    }
+    SerialReader *reader = session.reader;
+    QMetaObject::invokeMethod(reader, [reader, ring, attach]() {
+        reader->setRecordRing(attach ? ring : nullptr);
+    }, Qt::BlockingQueuedConnection);
+}
+
+void MainWindow::refreshDeviceStatus() {
+    if (!statusTable) return;
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const double seconds = lastStatusRefresh.isValid()
+                               ? qMax<qint64>(1, lastStatusRefresh.msecsTo(now)) / 1000.0
+                               : 1.0;
+    lastStatusRefresh = now;
+
+    const RenderScheduler::FrameStats frames = renderScheduler->takeFrameStats();
+    frameStatus->setText(QString("Frames: %1/s, render %2 ms average, %3 ms worst")
+                             .arg(frames.frames / seconds, 0, 'f', 0)
+                             .arg(frames.frames ? frames.totalNs / 1e6 / frames.frames : 0.0, 0, 'f', 2)
+                             .arg(frames.maxNs / 1e6, 0, 'f', 2));
+
+    statusTable->setRowCount(int(sessions.size()));
+    for (int row = 0; row < int(sessions.size()); ++row) {
+        PortSession &session = *sessions[size_t(row)];
+
+        // Everything the reader produced, including what the ring dropped
+        const quint64 overruns = session.ring.overruns();
+        const quint64 produced = session.ring.pushed() + overruns;
+        const double rate = (produced - session.lastSampleCount) / seconds;
+        if (produced != session.lastSampleCount)
+            session.lastUpdate = now;
+        session.lastSampleCount = produced;
+
+        const quint64 bytes = session.reader->bytesRead();
+        const double byteRate = (bytes - session.lastByteCount) / seconds;
+        session.lastByteCount = bytes;
+
+        const size_t fill = session.ring.size();
+        if (overruns != session.reportedOverruns) {
+            qWarning() << session.settings.portName << "sample ring overrun, dropped"
+                       << overruns - session.reportedOverruns << "samples";
+            session.reportedOverruns = overruns;
+        }
+
+        QString latency = "-";
+        if (measuringLatency && session.latency.count() > 0) {
+            latency = QString("%1 / %2 / %3")
+                          .arg(session.latency.percentile(50) / 1e6, 0, 'f', 2)
+                          .arg(session.latency.percentile(99) / 1e6, 0, 'f', 2)
+                          .arg(session.latency.max() / 1e6, 0, 'f', 2);
+        }
+        session.latencyTotal.add(session.latency);
+        session.latency.clear();
+
+        // Last value of every channel, in channel order
+        QStringList values;
+        const size_t firstKey = size_t(session.device) * maxChannels;
+        for (size_t key = firstKey; key < qMin(traces.size(), firstKey + maxChannels); ++key) {
+            if (traces[key]) values << QString::number(traces[key]->lastValue);
+        }
+        const QStringList cells = {
+            session.settings.portName,
+            session.reader->isOpen() ? "Connected" : "Disconnected",
+            session.settings.baudRate > 0 ? QString::number(session.settings.baudRate) : QString("-"),
+            QString::number(rate, 'f', 0),
+            QString::number(byteRate, 'f', 0),
+            QString("%1% (%2)").arg(fill * 100 / session.ring.capacity()).arg(fill),
+            QString::number(overruns),
+            QString::number(session.reader->parseErrors()),
+            QString::number(session.reader->crcErrors()),
+            QString::number(session.reader->sequenceGaps()),
+            latency,
+            values.join(", "),
+            session.lastUpdate.toString("hh:mm:ss")
+        };
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = statusTable->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem;
+                statusTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
+
+ChannelTrace *MainWindow::traceFor(int device, int channel) {
+    if (device < 0 || channel < 0 || channel >= maxChannels) return nullptr;
+    const size_t key = size_t(device) * maxChannels + size_t(channel);
+    if (key < traces.size() && traces[key])
+        return traces[key].get();
+
+    if (key >= traces.size())
+        traces.resize(key + 1);
+
+    auto trace = std::make_unique<ChannelTrace>(retentionSamples);
+    trace->series = new QLineSeries();
+    trace->series->setName(QString("%1 ch %2").arg(deviceNames.value(device, "Device")).arg(channel));
+    chart->addSeries(trace->series);
+    trace->series->attachAxis(chart->axisX());
+    trace->series->attachAxis(chart->axisY());
+    chart->legend()->setVisible(chart->series().size() > 1);
+    trace->plotTrace = rasterPlot->addTrace(trace->series->color());
+    heatmapX->addItem(trace->series->name(), int(key));
+    heatmapY->addItem(trace->series->name(), int(key));
+    if (heatmapY->count() == 2)
+        heatmapY->setCurrentIndex(1);
+
+    // Per-channel visibility toggle
+    QLineSeries *series = trace->series;
+    const int plotTrace = trace->plotTrace;
+    trace->visibilityAction = channelMenu->addAction(series->name());
+    trace->visibilityAction->setCheckable(true);
+    trace->visibilityAction->setChecked(true);
+    connect(trace->visibilityAction, &QAction::toggled, this, [this, series, plotTrace](bool visible) {
+        series->setVisible(visible && !playback);
+        rasterPlot->setTraceVisible(plotTrace, visible);
+        if (visible) refreshVisibleSeries();
+    });
+
+    traces[key] = std::move(trace);
+    return traces[key].get();
+}
+
+qint64 MainWindow::liveEnd() const {
+    qint64 end = 0;
+    for (const auto &trace : traces) {
+        if (trace) end = qMax(end, trace->history.endIndex());
+    }
+    return end;
+}
 
-    double currentMax = *std::max_element(yValueHistory.begin(), yValueHistory.end());
+void MainWindow::alignDevices() {
+    // Each device is plotted by its own sample index. While following, its
+    // newest sample is put on the live edge, so a slower device scrolls at
+    // its own rate instead of falling behind the fastest one
+    const qint64 end = liveEnd();
+    for (size_t first = 0; first < traces.size(); first += maxChannels) {
+        const size_t last = qMin(traces.size(), first + maxChannels);
+        qint64 deviceEnd = 0;
+        for (size_t key = first; key < last; ++key) {
+            if (traces[key]) deviceEnd = qMax(deviceEnd, traces[key]->history.endIndex());
+        }
+        for (size_t key = first; key < last; ++key) {
+            if (traces[key]) traces[key]->xOffset = end - deviceEnd;
+        }
+    }
+}
+
+void MainWindow::refreshVisibleSeries() {
+    TraceScope trace("MainWindow::refreshVisibleSeries");
+    if (!chart) return;
+
+    const qint64 first = qMax<qint64>(0, viewEnd - visibleSpan);
+    const int pixels = qMax(1, int(chart->plotArea().width()));
+    if (playback) {
+        refreshPlayback(first, pixels);
+        return;
+    }
+
+    for (const auto &trace : traces) {
+        if (trace && trace->series->isVisible())
+            refreshTrace(*trace, first, pixels);
+    }
+
+    updatingAxisX = true;
+    chart->axisX()->setRange(first, first + visibleSpan);
+    updatingAxisX = false;
+}
 
-    double suggestedMax = currentMax + 1;
-    if (suggestedMax < maxYValue - 20) {
-        maxYValue = suggestedMax;
-        chart->axisY()->setRange(0, maxYValue);
-        qDebug() << "Shrinking Y-axis to:" << maxYValue;
+static void appendTracePoints(const ChannelTrace &trace, qint64 begin, qint64 end, int level,
+                              QList<QPointF> &out) {
+    // Raw samples while they are still retained, the pyramid otherwise
+    const SampleBuffer &history = trace.history;
+    if (level < 0 && begin >= history.firstIndex()) {
+        out.reserve(out.size() + qsizetype(qMax<qint64>(0, end - begin)));
+        for (qint64 i = begin; i < end; ++i)
+            out.append(QPointF(i + trace.xOffset, history.at(i).value));
+    } else {
+        const qsizetype from = out.size();
+        trace.decimation.query(begin, end, qMax(0, level), out);
+        if (trace.xOffset != 0) {
+            for (qsizetype i = from; i < out.size(); ++i)
+                out[i].rx() += trace.xOffset;
+        }
+    }
+}
+
+// Points of a trace for [first, last) on the X axis, reduced for a page `pixels` wide
+static void appendPagePoints(const ChannelTrace &trace, qint64 first, qint64 last, int pixels,
+                             QList<QPointF> &out) {
+    const qint64 begin = qMax<qint64>(0, first - trace.xOffset);
+    const qint64 end = qMin(last - trace.xOffset, trace.history.endIndex());
+    if (end > begin)
+        appendTracePoints(trace, begin, end, trace.decimation.chooseLevel(last - first, pixels), out);
+}
+
+void MainWindow::refreshTrace(ChannelTrace &trace, qint64 first, int pixels) {
+    // Rebuild the on-screen window instead of growing the series: raw samples
+    // when they are dense enough, otherwise the matching decimation level
+    const SampleBuffer &history = trace.history;
+    const qint64 margin = visibleSpan / 10;
+    const qint64 begin = qMax<qint64>(0, first - margin - trace.xOffset);
+    const qint64 end = qMin(viewEnd + margin - trace.xOffset, history.endIndex());
+    const int level = trace.decimation.chooseLevel(viewEnd - first, pixels);
+
+    trace.visiblePoints.clear();
+    if (end > begin)
+        appendTracePoints(trace, begin, end, level, trace.visiblePoints);
+    trace.series->replace(trace.visiblePoints);
+}
+
+namespace {
+
+QString pageTitle(const QString &title, int page, int pageCount) {
+    return pageCount > 1 ? QString("%1 (page %2 of %3)").arg(title).arg(page + 1).arg(pageCount) : title;
+}
+
+int pagesFor(qint64 end, qint64 span) {
+    return int(qBound<qint64>(1, (end + span - 1) / span, std::numeric_limits<int>::max()));
+}
+
+// Pages of a capture, one per `span` samples. The file is opened again and
+// indexed on the exporter's thread, so the playback view is never shared.
+class CapturePages : public ChartPageSource {
+public:
+    CapturePages(const QString &fileName, qint64 span, int pixels)
+        : fileName(fileName), span(qMax<qint64>(1, span)), pixels(pixels) {}
+
+    void addChannel(quint32 key, const QString &name, const QColor &color) {
+        shown.push_back(Shown{key, name, color, -1});
+    }
+
+    bool prepare(QString *errorString) override {
+        if (!capture.open(fileName)) {
+            *errorString = capture.errorString();
+            return false;
+        }
+        while (capture.indexMore(4096)) {}
+
+        qint64 end = 0;
+        for (const CaptureFile::Channel &channel : capture.channels())
+            end = qMax(end, channel.sampleCount());
+        pages = pagesFor(end, span);
+
+        for (Shown &channel : shown) {
+            for (size_t i = 0; i < capture.channels().size(); ++i) {
+                if (capture.channels()[i].key == channel.key)
+                    channel.index = int(i);
+            }
+        }
+        return true;
+    }
+
+    int pageCount() const override { return pages; }
+
+    ChartPage page(int index) override {
+        ChartPage page;
+        page.title = pageTitle(QFileInfo(fileName).fileName(), index, pages);
+        page.xLabel = "Samples";
+        const qint64 begin = qint64(index) * span;
+        page.xMin = begin;
+        page.xMax = begin + span;
+        for (const Shown &channel : shown) {
+            ChartPage::Trace trace{channel.name, channel.color, {}};
+            if (channel.index >= 0)
+                capture.query(channel.index, begin, begin + span, pixels, trace.points);
+            page.traces.push_back(std::move(trace));
+        }
+        page.fitY();
+        return page;
+    }
+
+private:
+    struct Shown {
+        quint32 key;
+        QString name;
+        QColor color;
+        int index;                  // channel index in `capture`
+    };
+
+    QString fileName;
+    qint64 span;
+    int pixels;
+    int pages = 0;
+    CaptureFile capture;
+    std::vector<Shown> shown;
+};
+
+// Pages of the live traces, one per `span` X units. The traces are copied
+// when the export starts, since the GUI keeps appending to them.
+class TracePages : public ChartPageSource {
+public:
+    TracePages(qint64 end, qint64 span, int pixels)
+        : span(qMax<qint64>(1, span)), pixels(pixels), pages(pagesFor(end, this->span)) {}
+
+    void addTrace(const ChannelTrace &trace) {
+        shown.push_back(Shown{trace.series->name(), trace.series->color(), trace});
+    }
+
+    int pageCount() const override { return pages; }
+
+    ChartPage page(int index) override {
+        ChartPage page;
+        page.title = pageTitle("Data View", index, pages);
+        page.xLabel = "Samples";
+        const qint64 begin = qint64(index) * span;
+        page.xMin = begin;
+        page.xMax = begin + span;
+        for (const Shown &shownTrace : shown) {
+            ChartPage::Trace trace{shownTrace.name, shownTrace.color, {}};
+            appendPagePoints(shownTrace.trace, begin, begin + span, pixels, trace.points);
+            page.traces.push_back(std::move(trace));
+        }
+        page.fitY();
+        return page;
+    }
+
+private:
+    struct Shown {
+        QString name;
+        QColor color;
+        ChannelTrace trace;
+    };
+
+    qint64 span;
+    int pixels;
+    int pages;
+    std::vector<Shown> shown;
+};
+
+}
+
+void MainWindow::onAxisXRangeChanged(qreal min, qreal max) {
+    if (updatingAxisX) return;
+
+    // Zoom or pan by the user: resample the new range and stop following
+    // the live edge until it is brought back into view
+    visibleSpan = qMax<qint64>(2, qint64(max - min));
+    viewEnd = qint64(max);
+    followLive = !playback && viewEnd >= liveEnd();
+    refreshVisibleSeries();
+    chart->axisY()->setRange(minYValue, maxYValue);
+}
+
+void MainWindow::refreshPlayback(qint64 first, int pixels) {
+    // Only the visible range is decoded from the mapping
+    double low = 0, high = 0;
+    bool haveRange = false;
+    for (size_t i = 0; i < playbackSeries.size(); ++i) {
+        playbackPoints.clear();
+        if (playbackSeries[i]->isVisible())
+            playback->query(int(i), first, viewEnd, pixels, playbackPoints);
+        for (const QPointF &point : std::as_const(playbackPoints)) {
+            low = haveRange ? qMin(low, point.y()) : point.y();
+            high = haveRange ? qMax(high, point.y()) : point.y();
+            haveRange = true;
+        }
+        playbackSeries[i]->replace(playbackPoints);
+    }
+
+    updatingAxisX = true;
+    chart->axisX()->setRange(first, first + visibleSpan);
+    updatingAxisX = false;
+    if (haveRange)
+        chart->axisY()->setRange(low - 1, high + 1);
+}
+
+void MainWindow::indexPlayback() {
+    if (!playback) {
+        indexTimer->stop();
+        return;
+    }
+
+    // Queries only see indexed blocks, so redraw while the view is still being filled in
+    bool viewIncomplete = playback->channels().empty();
+    for (const CaptureFile::Channel &channel : playback->channels())
+        viewIncomplete = viewIncomplete || channel.sampleCount() < viewEnd;
+
+    const size_t knownChannels = playbackSeries.size();
+    if (!playback->indexMore(512)) {
+        indexTimer->stop();
+        statusBar()->showMessage(QString("Indexed %1").arg(playback->fileName()), 3000);
+    } else {
+        statusBar()->showMessage(QString("Indexing capture... %1%").arg(playback->indexProgress()));
+    }
+
+    // Channels can first appear deep inside the file
+    for (size_t i = knownChannels; i < playback->channels().size(); ++i) {
+        QLineSeries *series = new QLineSeries();
+        series->setName(playback->channels()[i].name);
+        chart->addSeries(series);
+        series->attachAxis(chart->axisX());
+        series->attachAxis(chart->axisY());
+        playbackSeries.push_back(series);
+    }
+    if (playbackSeries.size() != knownChannels)
+        chart->legend()->setVisible(playbackSeries.size() > 1);
+
+    // Names past the header's table are in name blocks at the end of the file
+    if (playback->isIndexComplete()) {
+        for (size_t i = 0; i < playbackSeries.size(); ++i)
+            playbackSeries[i]->setName(playback->channels()[i].name);
+    }
+    if (playbackSeries.size() != knownChannels || viewIncomplete)
+        refreshVisibleSeries();
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event) {
+    // Pan the Data View with the mouse wheel or the arrow keys
+    if (chart && (watched == chartView || (chartView && watched == chartView->viewport()))) {
+        qreal dx = 0;
+        if (event->type() == QEvent::Wheel) {
+            const QPoint delta = static_cast<QWheelEvent *>(event)->angleDelta();
+            dx = -(delta.x() ? delta.x() : delta.y()) / 120.0 * chart->plotArea().width() / 10;
+        } else if (event->type() == QEvent::KeyPress) {
+            const int key = static_cast<QKeyEvent *>(event)->key();
+            if (key == Qt::Key_Left) dx = -chart->plotArea().width() / 10;
+            if (key == Qt::Key_Right) dx = chart->plotArea().width() / 10;
+        }
+        if (dx != 0) {
+            chart->scroll(dx, 0);
+            return true;
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::followLiveData() {
+    if (playback) return;
+
+    visibleSpan = 100;
+    followLive = true;
+    alignDevices();
+    viewEnd = qMax(visibleSpan, liveEnd());
+    refreshVisibleSeries();
+}
+
+void MainWindow::setRasterPlot(bool enabled) {
+    QSettings().setValue("dataView/rasterPlot", enabled);
+    if (!enabled) {
+        dataViewStack->setCurrentWidget(chartView);
+        refreshVisibleSeries();
+        return;
+    }
+
+    // Seed the plot with the last screen of every trace, then feed it per frame
+    rasterPlot->setSpan(QSettings().value("dataView/rasterSpan", 20000).toLongLong());
+    rasterPlot->setYRange(minYValue, maxYValue);
+    for (const auto &trace : traces) {
+        if (!trace) continue;
+        const SampleBuffer &history = trace->history;
+        const qint64 first = qMax(history.firstIndex(), history.endIndex() - rasterPlot->span());
+        rasterPlot->restartTrace(trace->plotTrace, first);
+        for (qint64 i = first; i < history.endIndex(); ++i)
+            rasterPlot->append(trace->plotTrace, float(history.at(i).value));
+    }
+    dataViewStack->setCurrentWidget(rasterPlot);
+}
+
+void MainWindow::checkAutoShrinkYAxis() {
+    if (yRange.isEmpty() || playback) return;
+
+    // Zero stays in view for all-positive (or all-negative) data
+    double suggestedMax = qMax(0.0, yRange.max() + 1);
+    double suggestedMin = qMin(0.0, yRange.min() - 1);
+    if (suggestedMax < maxYValue - 20 || suggestedMin > minYValue + 20) {
+        if (suggestedMax < maxYValue - 20) maxYValue = suggestedMax;
+        if (suggestedMin > minYValue + 20) minYValue = suggestedMin;
+        chart->axisY()->setRange(minYValue, maxYValue);
+        rasterPlot->setYRange(minYValue, maxYValue);
+        qDebug() << "Shrinking Y-axis to:" << minYValue << maxYValue;
     }
 }
 
@@ -126,8 +734,14 @@ void MainWindow::setupMenuBar() {
     QMenu *deviceMenu = menuBar()->addMenu("Device");
     deviceMenu->addAction("Open Port", this, &MainWindow::openPort);
     deviceMenu->addAction("Disconnect Port", this, &MainWindow::disconnectPort);
+    deviceMenu->addAction("Open Simulated Device...", this, &MainWindow::openSimulator);
     deviceMenu->addAction("Discover", this, &MainWindow::discoverDevices);
     deviceMenu->addAction("Start Reading Data / Stop", this, &MainWindow::toggleReading);
+    deviceMenu->addSeparator();
+    QAction *latencyAction = deviceMenu->addAction("Measure Latency");
+    latencyAction->setCheckable(true);
+    connect(latencyAction, &QAction::toggled, this, &MainWindow::setLatencyMeasurement);
+    deviceMenu->addAction("Save Latency Report...", this, &MainWindow::saveLatencyReport);
 
     QMenu *readingMenu = menuBar()->addMenu("Reading Data");
     readingMenu->addAction("Start Recording Data / Stop", this, &MainWindow::toggleRecording);
@@ -142,6 +756,11 @@ void MainWindow::setupMenuBar() {
     viewMenu->addAction("3D Visualizer Window", this, &MainWindow::open3DVisualizerWindow);
     viewMenu->addAction("Data View Window", this, &MainWindow::openDataViewWindow);
     viewMenu->addAction("Device Status Window", this, &MainWindow::openDeviceStatusWindow);
+    viewMenu->addAction("Follow Live Data", this, &MainWindow::followLiveData);
+    rasterPlotAction = viewMenu->addAction("High-Rate Raster Plot");
+    rasterPlotAction->setCheckable(true);
+    connect(rasterPlotAction, &QAction::toggled, this, &MainWindow::setRasterPlot);
+    channelMenu = viewMenu->addMenu("Channels");
     viewMenu->addSeparator();
     viewMenu->addAction("Tile Windows", this, &MainWindow::tileWindows);
     viewMenu->addAction("Cascade Windows", this, &MainWindow::cascadeWindows);
@@ -152,6 +771,11 @@ void MainWindow::setupMenuBar() {
     helpMenu->addAction("Documentation", this, &MainWindow::openDocumentation);
     helpMenu->addAction("Support", this, &MainWindow::openSupport);
     helpMenu->addAction("About", this, &MainWindow::openAbout);
+    helpMenu->addSeparator();
+    QAction *traceAction = helpMenu->addAction("Record Performance Trace");
+    traceAction->setCheckable(true);
+    connect(traceAction, &QAction::toggled, this, &MainWindow::setTracing);
+    helpMenu->addAction("Save Performance Trace...", this, &MainWindow::saveTrace);
 }
 
 void MainWindow::setupToolBar() {
@@ -187,9 +811,9 @@ void MainWindow::setupToolBar() {
     connect(playAction, &QAction::triggered, this, &MainWindow::toggleReading);
     toolBar->addAction(playAction);
 
-    // QAction *recordAction = new QAction(QApplication::style()->standardIcon(QStyle::SP_MediaRecord), "Record", this);
-    // connect(recordAction, &QAction::triggered, this, &MainWindow::toggleRecording);
-    // toolBar->addAction(recordAction);
+    QAction *recordAction = new QAction(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton), "Record", this);
+    connect(recordAction, &QAction::triggered, this, &MainWindow::toggleRecording);
+    toolBar->addAction(recordAction);
 
     QAction *stopAction = new QAction(QApplication::style()->standardIcon(QStyle::SP_MediaStop), "Stop", this);
     connect(stopAction, &QAction::triggered, this, &MainWindow::resetLayout);
@@ -229,23 +853,71 @@ void MainWindow::createPositionedSubWindows() {
         QVBoxLayout *layout = new QVBoxLayout(content);
 
         if (name == "Data View") {
-            series = new QLineSeries();
             chart = new QChart();
             chart->legend()->hide();
-            chart->addSeries(series);
-            chart->createDefaultAxes();
-            chart->axisX()->setRange(0, 100);
-            chart->axisY()->setRange(0, maxYValue);
+            QValueAxis *axisX = new QValueAxis;
+            QValueAxis *axisY = new QValueAxis;
+            chart->addAxis(axisX, Qt::AlignBottom);
+            chart->addAxis(axisY, Qt::AlignLeft);
+            axisX->setRange(0, visibleSpan);
+            axisX->setTitleText("Samples");
+            axisY->setRange(minYValue, maxYValue);
+
+            // Drag to zoom into a range, right-click to zoom back out
+            connect(axisX, &QValueAxis::rangeChanged, this, &MainWindow::onAxisXRangeChanged);
 
             chartView = new QChartView(chart);
             chartView->setRenderHint(QPainter::Antialiasing);
-            layout->addWidget(chartView);
+            chartView->setRubberBand(QChartView::HorizontalRubberBand);
+            chartView->installEventFilter(this);
+            chartView->viewport()->installEventFilter(this);
+
+            rasterPlot = new TracePlotWidget;
+            dataViewStack = new QStackedWidget;
+            dataViewStack->addWidget(chartView);
+            dataViewStack->addWidget(rasterPlot);
+            layout->addWidget(dataViewStack);
+        }
+
+        if (name == "3D Visualizer") {
+            heatmapMode = new QComboBox;
+            heatmapMode->addItems({ "Value vs. Change", "Channel X vs. Channel Y" });
+            heatmapX = new QComboBox;
+            heatmapY = new QComboBox;
+            heatmapCounts = new QComboBox;
+            heatmapCounts->addItems({ "All Samples", "Decay (10 s)", "Last 30 s" });
+
+            QHBoxLayout *controls = new QHBoxLayout;
+            controls->addWidget(heatmapMode);
+            controls->addWidget(new QLabel("X:"));
+            controls->addWidget(heatmapX, 1);
+            controls->addWidget(new QLabel("Y:"));
+            controls->addWidget(heatmapY, 1);
+            controls->addWidget(heatmapCounts);
+            layout->addLayout(controls);
+
+            heatmap = new Fake3DChart;
+            layout->addWidget(heatmap, 1);
+            heatmapStatus = new QLabel;
+            layout->addWidget(heatmapStatus);
+
+            heatmapFeeder.setBudgetNs(QSettings().value("visualizer/budgetUs", 1000).toLongLong() * 1000);
+            for (QComboBox *box : { heatmapMode, heatmapX, heatmapY, heatmapCounts })
+                connect(box, &QComboBox::currentIndexChanged, this, &MainWindow::configureHeatmap);
+            configureHeatmap();
         }
 
         if (name == "Device Status") {
-            statusLabel = new QLabel("Disconnected");
-            statusLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
-            layout->addWidget(statusLabel);
+            statusTable = new QTableWidget(0, 13);
+            statusTable->setHorizontalHeaderLabels({ "Port", "Status", "Baud", "Samples/s", "Bytes/s",
+                                                     "Ring Fill", "Dropped", "Parse Errors", "CRC Errors",
+                                                     "Seq Gaps", "Latency p50/p99/max (ms)",
+                                                     "Last Value", "Last Update" });
+            statusTable->verticalHeader()->hide();
+            statusTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+            layout->addWidget(statusTable);
+            frameStatus = new QLabel;
+            layout->addWidget(frameStatus);
         }
 
         content->setLayout(layout);
@@ -271,6 +943,7 @@ void MainWindow::createPositionedSubWindows() {
     }
 
     mdiArea->tileSubWindows();
+    rasterPlotAction->setChecked(QSettings().value("dataView/rasterPlot", false).toBool());
 }
 
 
@@ -304,15 +977,123 @@ void MainWindow::restoreSubWindow() {
     taskBarButtons.remove(btn);
 }
 
+void MainWindow::setTracing(bool enabled) {
+    // Each recording starts from an empty trace
+    if (enabled)
+        Tracing::clear();
+    Tracing::setEnabled(enabled);
+    statusBar()->showMessage(enabled ? "Recording performance trace" : "Performance trace stopped", 3000);
+}
+
+void MainWindow::saveTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Performance Trace", "trace.json",
+                                                    "Chrome Trace (*.json)");
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (!Tracing::writeChromeJson(fileName, &error)) {
+        QMessageBox::critical(this, "Error", "Failed to save the trace.\n" + error);
+        return;
+    }
+    statusBar()->showMessage("Saved " + QFileInfo(fileName).fileName()
+                                 + " (open it in chrome://tracing or ui.perfetto.dev)", 5000);
+}
+
+void MainWindow::recordLatency(const QVector<Sample> &batch) {
+    if (!measuringLatency || batch.isEmpty()) return;
+    TraceScope trace("MainWindow::recordLatency");
+
+    // Devices are interleaved in time order, so look sessions up by id
+    std::vector<PortSession *> byDevice(size_t(deviceNames.size()), nullptr);
+    for (const auto &session : sessions) {
+        if (session->device >= 0 && session->device < int(byDevice.size()))
+            byDevice[size_t(session->device)] = session.get();
+    }
+
+    const qint64 now = steadyClockNs();
+    for (const Sample &sample : batch) {
+        PortSession *session = sample.device < byDevice.size() ? byDevice[sample.device] : nullptr;
+        if (session)
+            session->latency.record(now - sample.timestampNs);
+    }
+}
+
+void MainWindow::setLatencyMeasurement(bool enabled) {
+    // Each measurement starts from empty histograms
+    if (enabled) {
+        for (const auto &session : sessions) {
+            session->latency.clear();
+            session->latencyTotal.clear();
+        }
+        latencySince = QDateTime::currentDateTime();
+    }
+    measuringLatency = enabled;
+    refreshDeviceStatus();
+    statusBar()->showMessage(enabled ? "Measuring latency" : "Latency measurement stopped", 3000);
+}
+
+void MainWindow::saveLatencyReport() {
+    if (!latencySince.isValid()) {
+        QMessageBox::information(this, "Info", "Turn on Device > Measure Latency first.");
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Latency Report", "latency.json",
+                                                    "JSON (*.json)");
+    if (fileName.isEmpty()) return;
+
+    QJsonArray devices;
+    for (const auto &session : sessions) {
+        LatencyHistogram latency = session->latencyTotal;
+        latency.add(session->latency);
+
+        QJsonObject ns;
+        ns["min"] = latency.min();
+        ns["mean"] = latency.mean();
+        ns["p50"] = latency.percentile(50);
+        ns["p90"] = latency.percentile(90);
+        ns["p99"] = latency.percentile(99);
+        ns["p99.9"] = latency.percentile(99.9);
+        ns["max"] = latency.max();
+
+        // Non-empty buckets as [lowest ns, highest ns, count]
+        QJsonArray buckets;
+        latency.forEachBucket([&buckets](qint64 lowest, qint64 highest, quint64 count) {
+            buckets.append(QJsonArray{ lowest, highest, qint64(count) });
+        });
+
+        QJsonObject device;
+        device["port"] = session->settings.portName;
+        device["samples"] = qint64(latency.count());
+        device["latency_ns"] = ns;
+        device["histogram"] = buckets;
+        device["sequence_gaps"] = qint64(session->reader->sequenceGaps());
+        device["ring_overruns"] = qint64(session->ring.overruns());
+        device["parse_errors"] = qint64(session->reader->parseErrors());
+        device["crc_errors"] = qint64(session->reader->crcErrors());
+        devices.append(device);
+    }
+
+    QJsonObject report;
+    report["started"] = latencySince.toString(Qt::ISODate);
+    report["saved"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["measuring"] = measuringLatency;
+    report["devices"] = devices;
+
+    QSaveFile file(fileName);
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        QMessageBox::critical(this, "Error", "Failed to save the latency report.\n" + file.errorString());
+        return;
+    }
+    statusBar()->showMessage("Saved " + QFileInfo(fileName).fileName(), 5000);
+}
+
 #define DEFINE_SLOT(name) void MainWindow::name() { qDebug() << #name " triggered"; }
-DEFINE_SLOT(closeFile)
-DEFINE_SLOT(exportData)
 DEFINE_SLOT(print)
 DEFINE_SLOT(openSettings)
 DEFINE_SLOT(exitApp)
 DEFINE_SLOT(discoverDevices)
 DEFINE_SLOT(toggleReading)
-DEFINE_SLOT(toggleRecording)
 DEFINE_SLOT(configureDevice)
 DEFINE_SLOT(calibrateDevice)
 DEFINE_SLOT(updateFirmware)
@@ -324,17 +1105,248 @@ DEFINE_SLOT(openDocumentation)
 DEFINE_SLOT(openSupport)
 DEFINE_SLOT(openAbout)
 
+void MainWindow::toggleRecording() {
+    if (recorder->isRecording()) {
+        for (const auto &session : sessions)
+            attachRecorder(*session, false);
+        QMetaObject::invokeMethod(recorder, &CaptureWriter::stop, Qt::BlockingQueuedConnection);
+        statusBar()->showMessage(QString("Recording stopped: %1 samples written, %2 dropped")
+                                     .arg(recorder->samplesWritten())
+                                     .arg(recorder->samplesDropped()), 5000);
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Record Capture", "", "Capture Files (*.cdx)");
+    if (fileName.isEmpty()) return;
+
+    bool started = false;
+    const QStringList names = deviceNames;
+    QMetaObject::invokeMethod(recorder, [this, fileName, names]() {
+        return recorder->start(fileName, names);
+    }, Qt::BlockingQueuedConnection, &started);
+
+    if (!started) {
+        QMessageBox::critical(this, "Error", "Could not start recording.\n" + recorder->lastError());
+    } else {
+        for (const auto &session : sessions)
+            attachRecorder(*session, true);
+        statusBar()->showMessage("Recording to " + fileName);
+    }
+}
+
 void MainWindow::openFile() {
-    qDebug() << "Open File triggered";
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Capture", "",
+                                                    "Capture Files (*.cdx);;Text Logs (*.csv *.txt *.log)");
+    if (fileName.isEmpty()) return;
+
+    closeFile();
+    if (QFileInfo(fileName).suffix().compare("cdx", Qt::CaseInsensitive) != 0) {
+        importTextFile(fileName);
+        return;
+    }
+
+    auto capture = std::make_unique<CaptureFile>();
+    if (!capture->open(fileName)) {
+        QMessageBox::critical(this, "Error", "Could not open capture.\n" + capture->errorString());
+        return;
+    }
+    playback = std::move(capture);
+
+    // Live traces stay in memory but are hidden while the capture is shown
+    for (const auto &trace : traces) {
+        if (trace) trace->series->hide();
+    }
+    followLive = false;
+    viewEnd = visibleSpan;
+
+    // Index just enough for the first screen; the rest follows in slices
+    indexTimer->start();
+    indexPlayback();
+    refreshVisibleSeries();
 }
 
+void MainWindow::importTextFile(const QString &fileName) {
+    if (importer) {
+        QMessageBox::warning(this, "Import", "Another file is still being imported.");
+        return;
+    }
 
+    importer = new TextImporter(fileName, retentionSamples, this);
+
+    QProgressDialog *progress = new QProgressDialog("Importing " + QFileInfo(fileName).fileName(),
+                                                    "Cancel", 0, 100, this);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+    progress->setMinimumDuration(500);
+    connect(importer, &TextImporter::progressChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, importer, &TextImporter::cancel);
+    // The dialog deletes itself when closed, possibly before the import
+    // ends, so it is closed from a connection that dies with it
+    connect(importer, &TextImporter::finished, progress, [this, progress]() {
+        progress->disconnect(importer);
+        progress->close();
+    });
+    connect(importer, &TextImporter::finished, this, &MainWindow::finishImport);
+    importer->start();
+}
 
-void MainWindow::openPort() {
-    if (serial->isOpen()) {
-        serial->close();
+void MainWindow::finishImport(bool ok) {
+    std::unique_ptr<TextImporter> done(importer);
+    importer = nullptr;
+
+    if (!ok) {
+        if (!done->errorString().isEmpty())
+            QMessageBox::critical(this, "Error", "Could not import file.\n" + done->errorString());
+        return;
+    }
+
+    // Each column becomes a channel of a device named after the file; the
+    // row number takes the place of the timestamp
+    const int device = deviceIdFor(QFileInfo(done->fileName()).fileName());
+    std::vector<TextImporter::Column> &columns = done->columns();
+    for (size_t channel = 0; channel < columns.size() && channel < size_t(maxChannels); ++channel) {
+        TextImporter::Column &column = columns[channel];
+        ChannelTrace *trace = traceFor(device, int(channel));
+        trace->xOffset = 0;
+        trace->decimation = std::move(column.decimation);
+        const qint64 firstRow = column.count - qint64(column.tail.size());
+        trace->history.clear(firstRow);
+        for (size_t i = 0; i < column.tail.size(); ++i)
+            trace->history.append(Sample{firstRow + qint64(i), column.tail[i], quint16(channel), quint16(device)});
+        trace->lastValue = column.tail.empty() ? 0.0 : column.tail.back();
+
+        if (column.count > 0) {
+            minYValue = qMin(minYValue, column.min - 1);
+            maxYValue = qMax(maxYValue, column.max + 1);
+        }
+    }
+
+    statusBar()->showMessage(QString("Imported %1 rows from %2 (%3 lines skipped)")
+                                 .arg(done->rowCount())
+                                 .arg(QFileInfo(done->fileName()).fileName())
+                                 .arg(done->parseErrors()), 5000);
+
+    // Show the whole log; live data keeps arriving but no longer scrolls the view
+    followLive = false;
+    visibleSpan = qMax<qint64>(2, done->rowCount());
+    viewEnd = visibleSpan;
+    chart->axisY()->setRange(minYValue, maxYValue);
+    refreshVisibleSeries();
+}
+
+void MainWindow::closeFile() {
+    if (!playback) return;
+
+    indexTimer->stop();
+    for (QLineSeries *series : playbackSeries) {
+        chart->removeSeries(series);
+        delete series;
+    }
+    playbackSeries.clear();
+    playback.reset();
+
+    for (const auto &trace : traces) {
+        if (trace && trace->visibilityAction->isChecked()) trace->series->show();
+    }
+    chart->legend()->setVisible(chart->series().size() > 1);
+    chart->axisY()->setRange(minYValue, maxYValue);
+    followLiveData();
+}
+
+
+
+void MainWindow::exportData() {
+    if (exporter) {
+        statusBar()->showMessage("An export is already running", 3000);
+        return;
+    }
+
+    bool ok = false;
+    const QStringList ranges = { "All retained samples", "Visible range" };
+    const QString range = QInputDialog::getItem(this, "Export Data", "Samples to export:", ranges, 0, false, &ok);
+    if (!ok) return;
+
+    const QStringList filters = { "CSV Files (*.csv)", "Capture Files (*.cdx)", "Raw Binary (*.bin)" };
+    const QStringList suffixes = { "csv", "cdx", "bin" };
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, "Export Data", "", filters.join(";;"), &selectedFilter);
+    if (fileName.isEmpty()) return;
+    if (QFileInfo(fileName).suffix().isEmpty())
+        fileName += "." + suffixes.value(filters.indexOf(selectedFilter), "csv");
+
+    // Snapshots share the trace buffers' storage, so nothing is copied here;
+    // formatting and writing happen on the exporter's thread
+    const bool visibleOnly = range == ranges[1];
+    const qint64 first = qMax<qint64>(0, viewEnd - visibleSpan);
+    const qint64 last = viewEnd;
+    std::vector<DataExporter::Channel> snapshot;
+    for (size_t key = 0; key < traces.size(); ++key) {
+        const ChannelTrace *trace = traces[key].get();
+        if (!trace) continue;
+        const SampleBuffer &history = trace->history;
+        DataExporter::Channel channel;
+        channel.samples = visibleOnly ? history.snapshot(first - trace->xOffset, last - trace->xOffset)
+                                      : history.snapshot(history.firstIndex(), history.endIndex());
+        if (channel.samples.isEmpty()) continue;
+
+        channel.name = trace->series->name();
+        channel.device = quint16(key / maxChannels);
+        channel.channel = quint16(key % maxChannels);
+        snapshot.push_back(std::move(channel));
+    }
+    if (snapshot.empty()) {
+        statusBar()->showMessage("Nothing to export", 3000);
+        return;
+    }
+
+    showExportProgress(fileName);
+    exporter = new DataExporter(fileName, DataExporter::formatForFile(fileName), std::move(snapshot), this);
+    connect(exporter, &DataExporter::progressChanged, exportProgress, &QProgressBar::setValue);
+    connect(exporter, &DataExporter::finished, this, &MainWindow::finishExport);
+    exporter->start();
+}
+
+void MainWindow::finishExport(bool ok) {
+    std::unique_ptr<DataExporter> done(exporter);
+    exporter = nullptr;
+    if (!chartExporter) {
+        exportProgress->hide();
+        exportCancel->hide();
+    }
+
+    if (ok) {
+        statusBar()->showMessage(QString("Exported %1 samples to %2")
+                                     .arg(done->samplesWritten())
+                                     .arg(done->fileName()), 5000);
+    } else if (done->isCanceled()) {
+        statusBar()->showMessage("Export canceled", 3000);
+    } else {
+        statusBar()->clearMessage();
+        QMessageBox::critical(this, "Error", "Could not export data.\n" + done->errorString());
     }
+}
+
+void MainWindow::showExportProgress(const QString &fileName) {
+    if (!exportProgress) {
+        exportProgress = new QProgressBar(this);
+        exportProgress->setRange(0, 100);
+        exportProgress->setMaximumWidth(200);
+        statusBar()->addPermanentWidget(exportProgress);
+        exportCancel = new QPushButton("Cancel", this);
+        connect(exportCancel, &QPushButton::clicked, this, &MainWindow::cancelExports);
+        statusBar()->addPermanentWidget(exportCancel);
+    }
+    exportProgress->setValue(0);
+    exportProgress->show();
+    exportCancel->show();
+    statusBar()->showMessage("Exporting to " + fileName);
+}
 
+void MainWindow::cancelExports() {
+    if (exporter) exporter->cancel();
+    if (chartExporter) chartExporter->cancel();
+}
+
+void MainWindow::openPort() {
     PortDialog dialog(this);
     if (dialog.exec() != QDialog::Accepted)
         return;
@@ -345,45 +1357,134 @@ void MainWindow::openPort() {
         return;
     }
 
-    currentPortName = portName;
+    for (const auto &session : sessions) {
+        if (session->settings.portName == portName) {
+            QMessageBox::information(this, "Info", portName + " is already open.");
+            return;
+        }
+    }
 
-    serial->setPortName(portName);
-    serial->setBaudRate(QSerialPort::Baud9600);
-    serial->setDataBits(QSerialPort::Data8);
-    serial->setParity(QSerialPort::NoParity);
-    serial->setStopBits(QSerialPort::OneStop);
-    serial->setFlowControl(QSerialPort::NoFlowControl);
+    const SerialSettings portSettings = dialog.settings();
+    QString error;
+    if (!startSession(portSettings, [portSettings](SerialReader *reader) {
+            return reader->openPort(portSettings);
+        }, &error)) {
+        QMessageBox::critical(this, "Error", "Failed to open port.\n" + error);
+        return;
+    }
 
-    if (!serial->open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(this, "Error", "Failed to open port.");
-    } else {
-        lastUpdateTime = QDateTime::currentDateTime();
-        QString statusText = QString("Status: Connected\n"
-                                     "Port: %1\n"
-                                     "Baud Rate: %2\n"
-                                     "Last Update: %3")
-                                 .arg(currentPortName)
-                                 .arg(serial->baudRate())
-                                 .arg(lastUpdateTime.toString("yyyy-MM-dd hh:mm:ss"));
-
-        if (statusLabel) {
-            statusLabel->setText(statusText);
+    portSettings.save();
+    QMessageBox::information(this, "Port Opened", "Connected to " + portName);
+}
+
+void MainWindow::openSimulator() {
+    SimulatorDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+    const SimulatorSettings simulation = dialog.settings();
+    simulation.save();
+
+    SerialSettings portSettings;
+    portSettings.decoder = simulation.framing;
+    QString error;
+    PortSession *session = nullptr;
+
+    if (simulation.output == SimulatorSettings::Output::PseudoTerminal) {
+        // The stream goes through a real QSerialPort on the slave side
+        auto simulator = std::make_unique<PtySimulator>(simulation);
+        if (!simulator->start()) {
+            QMessageBox::critical(this, "Error", "Failed to create a pseudo terminal.\n" + simulator->errorString());
+            return;
         }
+        portSettings.portName = simulator->slavePath();
+        session = startSession(portSettings, [portSettings](SerialReader *reader) {
+            return reader->openPort(portSettings);
+        }, &error);
+        if (session)
+            session->simulator = std::move(simulator);
+    } else {
+        // Named like a port so it gets its own device id and traces
+        int number = 1;
+        while (deviceNames.contains(QString("Simulator %1").arg(number)))
+            ++number;
+        portSettings.portName = QString("Simulator %1").arg(number);
+        portSettings.baudRate = 0;
+        session = startSession(portSettings, [simulation](SerialReader *reader) {
+            return reader->openSimulator(simulation);
+        }, &error);
+    }
 
-        QMessageBox::information(this, "Port Opened", "Connected to " + portName);
+    if (!session) {
+        QMessageBox::critical(this, "Error", "Failed to start the simulator.\n" + error);
+        return;
     }
+    statusBar()->showMessage("Simulating " + portSettings.portName, 3000);
+}
+
+PortSession *MainWindow::startSession(const SerialSettings &settings,
+                                      const std::function<bool(SerialReader *)> &open, QString *error) {
+    // Each port gets its own reader thread and ring. The device id is taken
+    // only once the port opened, so a failed attempt leaves no device behind.
+    auto session = std::make_unique<PortSession>(-1);
+    session->settings = settings;
+    session->thread = new QThread(this);
+    session->thread->setObjectName(settings.portName);
+    session->reader = new SerialReader(&session->ring);
+    session->reader->moveToThread(session->thread);
+    connect(session->thread, &QThread::finished, session->reader, &QObject::deleteLater);
+    session->thread->start();
+
+    SerialReader *reader = session->reader;
+    bool opened = false;
+    QMetaObject::invokeMethod(reader, [reader, &open]() {
+        return open(reader);
+    }, Qt::BlockingQueuedConnection, &opened);
+
+    if (!opened) {
+        *error = reader->lastError();
+        closeSession(*session);
+        return nullptr;
+    }
+
+    session->device = deviceIdFor(settings.portName);
+    session->lastUpdate = QDateTime::currentDateTime();
+    renderScheduler->addSource(session->device, &session->ring);
+    if (recorder->isRecording())
+        attachRecorder(*session, true);
+    sessions.push_back(std::move(session));
+    refreshDeviceStatus();
+    return sessions.back().get();
 }
 
 void MainWindow::disconnectPort() {
-    if (serial->isOpen()) {
-        serial->close();
-        if (statusLabel) {
-            statusLabel->setText("Status: Disconnected");
-        }
-        QMessageBox::information(this, "Disconnected", "Serial port disconnected.");
-    } else {
+    if (sessions.empty()) {
         QMessageBox::information(this, "Info", "No serial port is currently open.");
+        return;
+    }
+
+    QStringList names;
+    for (const auto &session : sessions)
+        names << session->settings.portName;
+
+    QString choice = names.first();
+    if (names.size() > 1) {
+        names.prepend("All Ports");
+        bool ok = false;
+        choice = QInputDialog::getItem(this, "Disconnect Port", "Port:", names, 0, false, &ok);
+        if (!ok) return;
+    }
+
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        if (choice == "All Ports" || (*it)->settings.portName == choice) {
+            closeSession(**it);
+            it = sessions.erase(it);
+        } else {
+            ++it;
+        }
     }
+    refreshDeviceStatus();
+
+    QMessageBox::information(this, "Disconnected", "Serial port disconnected.");
 }
 
 
@@ -434,44 +1535,124 @@ void MainWindow::resizeEvent(QResizeEvent *event) {
     resetLayout();
 }
 void MainWindow::exportChartAsImage() {
-    if (!chartView) return;
+    if (!chart) return;
+    if (chartExporter) {
+        statusBar()->showMessage("A chart export is already running", 3000);
+        return;
+    }
 
-    QString fileName = QFileDialog::getSaveFileName(this, "Save Chart Image", "", "PNG Image (*.png)");
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Chart Image", "", "PNG Image (*.png);;SVG Image (*.svg)");
     if (fileName.isEmpty()) return;
 
-    QPixmap pixmap(chartView->size());
-    QPainter painter(&pixmap);
-    chartView->render(&painter);
-    painter.end();
+    bool ok = false;
+    const QStringList sizes = { "Window size", "1920 x 1080", "3840 x 2160 (4K)", "7680 x 4320 (8K)" };
+    const QString size = QInputDialog::getItem(this, "Save Chart Image", "Image size:", sizes, 0, false, &ok);
+    if (!ok) return;
 
+    static const QSize presets[] = { QSize(), QSize(1920, 1080), QSize(3840, 2160), QSize(7680, 4320) };
+    const qsizetype preset = sizes.indexOf(size);
+    const QSize pixelSize = preset > 0 ? presets[preset] : chartView->size();
 
-    if (!pixmap.save(fileName)) {
-        QMessageBox::warning(this, "Export Failed", "Could not save the image.");
-    } else {
-        QMessageBox::information(this, "Export Successful", "Chart saved as image.");
-    }
+    // The page is rebuilt from the traces for the target width, not grabbed from the view
+    const qint64 first = qMax<qint64>(0, viewEnd - visibleSpan);
+    std::vector<ChartPage> pages{ chartPage(first, first + visibleSpan, pixelSize.width()) };
+    startChartExport(new ChartExporter(fileName, pixelSize, 96, std::move(pages), this));
 }
 
 void MainWindow::exportChartAsPdf() {
-    if (!chartView) return;
+    if (!chart) return;
+    if (chartExporter) {
+        statusBar()->showMessage("A chart export is already running", 3000);
+        return;
+    }
 
     QString fileName = QFileDialog::getSaveFileName(this, "Save Chart PDF", "", "PDF Files (*.pdf)");
     if (fileName.isEmpty()) return;
 
-    QPdfWriter writer(fileName);
-    writer.setPageSize(QPageSize(QPageSize::A4));
-    QPainter painter(&writer);
+    bool ok = false;
+    const QStringList ranges = { "Visible range", "Entire capture, one page per screen" };
+    const QString range = QInputDialog::getItem(this, "Save Chart PDF", "Pages:", ranges, 0, false, &ok);
+    if (!ok) return;
+
+    // A4 landscape at 300 dpi is about 3500 pixels wide
+    const int dpi = 300;
+    const int pixels = qRound(297 / 25.4 * dpi);
+    if (range == ranges[0]) {
+        const qint64 first = qMax<qint64>(0, viewEnd - visibleSpan);
+        std::vector<ChartPage> pages{ chartPage(first, first + visibleSpan, pixels) };
+        startChartExport(new ChartExporter(fileName, QSize(), dpi, std::move(pages), this));
+        return;
+    }
 
-    // Scale chartView to fit PDF page
-    QSize viewSize = chartView->size();
-    QSize pdfSize(writer.width(), writer.height());
-    qreal xScale = pdfSize.width() / qreal(viewSize.width());
-    qreal yScale = pdfSize.height() / qreal(viewSize.height());
-    qreal scale = qMin(xScale, yScale);
-    painter.scale(scale, scale);
+    // Every page is built on the exporter's thread, as it is rendered
+    std::unique_ptr<ChartPageSource> source;
+    if (playback) {
+        auto capturePages = std::make_unique<CapturePages>(playback->fileName(), visibleSpan, pixels);
+        for (size_t i = 0; i < playbackSeries.size(); ++i) {
+            if (playbackSeries[i]->isVisible())
+                capturePages->addChannel(playback->channels()[i].key, playbackSeries[i]->name(),
+                                         playbackSeries[i]->color());
+        }
+        source = std::move(capturePages);
+    } else {
+        auto tracePages = std::make_unique<TracePages>(liveEnd(), visibleSpan, pixels);
+        for (const auto &trace : traces) {
+            if (trace && trace->series->isVisible())
+                tracePages->addTrace(*trace);
+        }
+        source = std::move(tracePages);
+    }
+    startChartExport(new ChartExporter(fileName, QSize(), dpi, std::move(source), this));
+}
 
-    chartView->render(&painter);
-    painter.end();
+ChartPage MainWindow::chartPage(qint64 first, qint64 last, int pixels) {
+    ChartPage page;
+    page.title = playback ? QFileInfo(playback->fileName()).fileName() : QString("Data View");
+    page.xLabel = "Samples";
+    page.xMin = first;
+    page.xMax = last;
+
+    if (playback) {
+        for (size_t i = 0; i < playbackSeries.size(); ++i) {
+            if (!playbackSeries[i]->isVisible()) continue;
+            ChartPage::Trace trace{playbackSeries[i]->name(), playbackSeries[i]->color(), {}};
+            playback->query(int(i), first, last, pixels, trace.points);
+            page.traces.push_back(std::move(trace));
+        }
+    } else {
+        for (const auto &channelTrace : traces) {
+            if (!channelTrace || !channelTrace->series->isVisible()) continue;
+            ChartPage::Trace trace{channelTrace->series->name(), channelTrace->series->color(), {}};
+            appendPagePoints(*channelTrace, first, last, pixels, trace.points);
+            page.traces.push_back(std::move(trace));
+        }
+    }
+    page.fitY();
+    return page;
+}
+
+void MainWindow::startChartExport(ChartExporter *exporter) {
+    showExportProgress(exporter->fileName());
+    chartExporter = exporter;
+    connect(chartExporter, &ChartExporter::progressChanged, exportProgress, &QProgressBar::setValue);
+    connect(chartExporter, &ChartExporter::finished, this, &MainWindow::finishChartExport);
+    chartExporter->start();
+}
 
-    QMessageBox::information(this, "Export Successful", "Chart saved as PDF.");
+void MainWindow::finishChartExport(bool ok) {
+    std::unique_ptr<ChartExporter> done(chartExporter);
+    chartExporter = nullptr;
+    if (!exporter) {
+        exportProgress->hide();
+        exportCancel->hide();
+    }
+
+    if (ok) {
+        statusBar()->showMessage("Chart saved to " + done->fileName(), 5000);
+    } else if (done->isCanceled()) {
+        statusBar()->showMessage("Chart export canceled", 3000);
+    } else {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "Export Failed", "Could not save the chart.\n" + done->errorString());
+    }
 }
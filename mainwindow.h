@@ -11,14 +11,37 @@
 #include <QSerialPort>
 #include <QLabel>
 #include <QDateTime>
+#include <QTableWidget>
+#include <QProgressBar>
+#include <QStackedWidget>
+#include <QComboBox>
+#include <QElapsedTimer>
 
-#include <QQueue>
 #include <QTimer>
+#include <QThread>
+#include <QMenu>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include <QtCharts/QChartView>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QValueAxis>
 
+#include "samplering.h"
+#include "portsession.h"
+#include "capturewriter.h"
+#include "capturefile.h"
+#include "renderscheduler.h"
+#include "channeltrace.h"
+#include "rollingminmax.h"
+#include "textimporter.h"
+#include "dataexporter.h"
+#include "chartrenderer.h"
+#include "traceplotwidget.h"
+#include "fake3dchart.h"
+#include "heatmapfeeder.h"
+
 QT_USE_NAMESPACE
 
     class MainWindow : public QMainWindow {
@@ -30,6 +53,7 @@ public:
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
     // File
@@ -45,8 +69,11 @@ private slots:
     // Device
     void openPort();
     void disconnectPort();
+    void openSimulator();
     void discoverDevices();
     void toggleReading();
+    void setLatencyMeasurement(bool enabled);
+    void saveLatencyReport();
 
     // Reading Data
     void toggleRecording();
@@ -61,6 +88,8 @@ private slots:
     void open3DVisualizerWindow();
     void openDataViewWindow();
     void openDeviceStatusWindow();
+    void followLiveData();
+    void setRasterPlot(bool enabled);
 
     // Window Management
     void cascadeWindows();
@@ -72,6 +101,9 @@ private slots:
     void openDocumentation();
     void openSupport();
     void openAbout();
+    void setTracing(bool enabled);
+    void saveTrace();
+    void cancelExports();
 
     void restoreSubWindow();
     void minimizeSubWindow(QMdiSubWindow *subWin);
@@ -83,32 +115,85 @@ private:
     QHBoxLayout *taskBarLayout;
     QMap<QPushButton*, QMdiSubWindow*> taskBarButtons;
 
-    QLabel *statusLabel = nullptr;
-    QString currentPortName;
-    int lastReceivedValue = 0;
-    QDateTime lastUpdateTime;
+    QTableWidget *statusTable = nullptr;
+    QLabel *frameStatus = nullptr;
+    QTimer *statusTimer = nullptr;
+    QDateTime lastStatusRefresh;
+    bool measuringLatency = false;
+    QDateTime latencySince;
 
 
 
-    // Serial Communication
-    QSerialPort *serial;
+    // Serial Communication: one reader thread per open port, merged by
+    // the render scheduler. deviceNames maps device ids to port names and
+    // is never shrunk, so a reopened port keeps its traces.
+    std::vector<std::unique_ptr<PortSession>> sessions;
+    QStringList deviceNames;
+    RenderScheduler *renderScheduler = nullptr;
     QPlainTextEdit *dataViewEdit;
 
-    // Data View Chart
-    QChart *chart = nullptr;
-    QChartView *chartView = nullptr;
-    QLineSeries *series = nullptr;
+    // Recording: frames are teed into a writer on its own thread
+    CaptureWriter *recorder = nullptr;
+    QThread *recorderThread = nullptr;
 
+    // Playback of a recorded capture; replaces the live traces while open
+    std::unique_ptr<CaptureFile> playback;
+    std::vector<QLineSeries *> playbackSeries;
+    QList<QPointF> playbackPoints;
+    QTimer *indexTimer = nullptr;
 
+    // Text log import running in the background; its columns become traces
+    TextImporter *importer = nullptr;
 
-    // Chart tracking
-    int dataPointIndex = 0;
-    int maxYValue = 50;
+    // Export running in the background, with its progress in the status bar
+    DataExporter *exporter = nullptr;
+    ChartExporter *chartExporter = nullptr;
+    QProgressBar *exportProgress = nullptr;
+    QPushButton *exportCancel = nullptr;
 
-    // Auto-shrink Y-axis
-    QQueue<int> yValueHistory;
+    // Data View Chart
+    QChart *chart = nullptr;
+    QChartView *chartView = nullptr;
+    QMenu *channelMenu = nullptr;
+
+    // High-rate alternative to the chart: a raster scope fed straight from
+    // the frames while it is the current page of the Data View
+    QStackedWidget *dataViewStack = nullptr;
+    TracePlotWidget *rasterPlot = nullptr;
+    QAction *rasterPlotAction = nullptr;
+
+    // 3D Visualizer: heatmap of point pairs taken from each frame. Feeding
+    // it is timed and thinned to stay within visualizer/budgetUs per frame
+    Fake3DChart *heatmap = nullptr;
+    QComboBox *heatmapMode = nullptr;
+    QComboBox *heatmapX = nullptr;
+    QComboBox *heatmapY = nullptr;
+    QComboBox *heatmapCounts = nullptr;
+    QLabel *heatmapStatus = nullptr;
+    HeatmapFeeder heatmapFeeder;
+    QElapsedTimer heatmapClock;
+    qint64 heatmapCostNs = 0;        // insertion time since the last status refresh
+    quint64 heatmapReportedFed = 0;
+    quint64 heatmapReportedSkipped = 0;
+
+
+    // Chart tracking: one trace per device channel, indexed by
+    // device * maxChannels + channel. Each
+    // series only holds the visible window plus a margin, the retained
+    // history lives in the trace's SampleBuffer
+    std::vector<std::unique_ptr<ChannelTrace>> traces;
+    static const int maxChannels = 256;
+    qsizetype retentionSamples = 250000;
+    qint64 visibleSpan = 100;
+    qint64 viewEnd = 0;
+    bool followLive = true;
+    bool updatingAxisX = false;
+    double minYValue = 0;
+    double maxYValue = 50;
+
+    // Auto-expand/shrink Y-axis over the last yRange.window() samples
+    RollingMinMax yRange;
     QTimer *shrinkTimer = nullptr;
-    const int maxHistorySize = 100;
 
     // Setup methods
     void setupMenuBar();
@@ -117,7 +202,32 @@ private:
     void createPositionedSubWindows();
     void addMinimizeContext(QMdiSubWindow *subWindow);
     void checkAutoShrinkYAxis();
-    void update3DVisualizer(int index, int value);
+    void renderFrame(const QVector<Sample> &batch);
+    void recordLatency(const QVector<Sample> &batch);
+    int deviceIdFor(const QString &portName);
+    PortSession *startSession(const SerialSettings &settings,
+                              const std::function<bool(SerialReader *)> &open, QString *error);
+    void closeSession(PortSession &session);
+    void attachRecorder(PortSession &session, bool attach);
+    void refreshDeviceStatus();
+    ChannelTrace *traceFor(int device, int channel);
+    qint64 liveEnd() const;
+    void alignDevices();
+    void refreshVisibleSeries();
+    void refreshPlayback(qint64 first, int pixels);
+    void indexPlayback();
+    void importTextFile(const QString &fileName);
+    void finishImport(bool ok);
+    void finishExport(bool ok);
+    void showExportProgress(const QString &fileName);
+    ChartPage chartPage(qint64 first, qint64 last, int pixels);
+    void startChartExport(ChartExporter *exporter);
+    void finishChartExport(bool ok);
+    void refreshTrace(ChannelTrace &trace, qint64 first, int pixels);
+    void onAxisXRangeChanged(qreal min, qreal max);
+    void update3DVisualizer(const QVector<Sample> &batch);
+    void configureHeatmap();
+    void refreshHeatmapStatus();
 };
 
 #endif // MAINWINDOW_H
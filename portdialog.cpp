@@ -1,6 +1,8 @@
 #include "portdialog.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QFormLayout>
+#include <QIntValidator>
 #include <QSerialPortInfo>
 #include <QLabel>
 
@@ -18,6 +20,58 @@ PortDialog::PortDialog(QWidget *parent) : QDialog(parent) {
     }
     layout->addWidget(portComboBox);
 
+    QFormLayout *form = new QFormLayout;
+
+    // Editable so custom rates the driver supports can be typed in
+    baudComboBox = new QComboBox(this);
+    baudComboBox->setEditable(true);
+    baudComboBox->setValidator(new QIntValidator(1, 100000000, baudComboBox));
+    const QList<qint32> rates = { 9600, 19200, 38400, 57600, 115200, 230400,
+                                  460800, 921600, 1000000, 2000000, 3000000 };
+    for (qint32 rate : rates)
+        baudComboBox->addItem(QString::number(rate));
+    form->addRow("Baud Rate:", baudComboBox);
+
+    dataBitsComboBox = new QComboBox(this);
+    dataBitsComboBox->addItem("5", QSerialPort::Data5);
+    dataBitsComboBox->addItem("6", QSerialPort::Data6);
+    dataBitsComboBox->addItem("7", QSerialPort::Data7);
+    dataBitsComboBox->addItem("8", QSerialPort::Data8);
+    form->addRow("Data Bits:", dataBitsComboBox);
+
+    parityComboBox = new QComboBox(this);
+    parityComboBox->addItem("None", QSerialPort::NoParity);
+    parityComboBox->addItem("Even", QSerialPort::EvenParity);
+    parityComboBox->addItem("Odd", QSerialPort::OddParity);
+    parityComboBox->addItem("Space", QSerialPort::SpaceParity);
+    parityComboBox->addItem("Mark", QSerialPort::MarkParity);
+    form->addRow("Parity:", parityComboBox);
+
+    stopBitsComboBox = new QComboBox(this);
+    stopBitsComboBox->addItem("1", QSerialPort::OneStop);
+    stopBitsComboBox->addItem("1.5", QSerialPort::OneAndHalfStop);
+    stopBitsComboBox->addItem("2", QSerialPort::TwoStop);
+    form->addRow("Stop Bits:", stopBitsComboBox);
+
+    flowControlComboBox = new QComboBox(this);
+    flowControlComboBox->addItem("None", QSerialPort::NoFlowControl);
+    flowControlComboBox->addItem("RTS/CTS", QSerialPort::HardwareControl);
+    flowControlComboBox->addItem("XON/XOFF", QSerialPort::SoftwareControl);
+    form->addRow("Flow Control:", flowControlComboBox);
+
+    readBufferSpinBox = new QSpinBox(this);
+    readBufferSpinBox->setRange(0, 64 * 1024);
+    readBufferSpinBox->setSuffix(" KiB");
+    readBufferSpinBox->setSpecialValueText("Unlimited");
+    form->addRow("Read Buffer:", readBufferSpinBox);
+
+    decoderComboBox = new QComboBox(this);
+    decoderComboBox->addItem("Text lines", int(SampleDecoder::Kind::TextLines));
+    decoderComboBox->addItem("Binary frames", int(SampleDecoder::Kind::BinaryFrames));
+    form->addRow("Protocol:", decoderComboBox);
+
+    layout->addLayout(form);
+
     QHBoxLayout *btnLayout = new QHBoxLayout;
     QPushButton *okBtn = new QPushButton("Open");
     QPushButton *cancelBtn = new QPushButton("Cancel");
@@ -27,8 +81,44 @@ PortDialog::PortDialog(QWidget *parent) : QDialog(parent) {
 
     connect(okBtn, &QPushButton::clicked, this, &QDialog::accept);
     connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
+
+    // Restore the saved configuration of whichever port is selected
+    connect(portComboBox, &QComboBox::currentTextChanged, this, &PortDialog::loadSettings);
+    int last = portComboBox->findText(SerialSettings::lastPortName());
+    if (last >= 0)
+        portComboBox->setCurrentIndex(last);
+    loadSettings(portComboBox->currentText());
+}
+
+void PortDialog::loadSettings(const QString &portName) {
+    const SerialSettings s = SerialSettings::load(portName);
+
+    baudComboBox->setCurrentText(QString::number(s.baudRate));
+    dataBitsComboBox->setCurrentIndex(dataBitsComboBox->findData(s.dataBits));
+    parityComboBox->setCurrentIndex(parityComboBox->findData(s.parity));
+    stopBitsComboBox->setCurrentIndex(stopBitsComboBox->findData(s.stopBits));
+    flowControlComboBox->setCurrentIndex(flowControlComboBox->findData(s.flowControl));
+    readBufferSpinBox->setValue(int(s.readBufferSize / 1024));
+    decoderComboBox->setCurrentIndex(decoderComboBox->findData(int(s.decoder)));
 }
 
 QString PortDialog::selectedPort() const {
     return portComboBox->currentText();
 }
+
+SampleDecoder::Kind PortDialog::selectedDecoder() const {
+    return SampleDecoder::Kind(decoderComboBox->currentData().toInt());
+}
+
+SerialSettings PortDialog::settings() const {
+    SerialSettings s;
+    s.portName = selectedPort();
+    s.baudRate = baudComboBox->currentText().toInt();
+    s.dataBits = QSerialPort::DataBits(dataBitsComboBox->currentData().toInt());
+    s.parity = QSerialPort::Parity(parityComboBox->currentData().toInt());
+    s.stopBits = QSerialPort::StopBits(stopBitsComboBox->currentData().toInt());
+    s.flowControl = QSerialPort::FlowControl(flowControlComboBox->currentData().toInt());
+    s.readBufferSize = qint64(readBufferSpinBox->value()) * 1024;
+    s.decoder = selectedDecoder();
+    return s;
+}
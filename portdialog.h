@@ -4,15 +4,30 @@
 #include <QDialog>
 #include <QComboBox>
 #include <QPushButton>
+#include <QSpinBox>
+
+#include "sampledecoder.h"
+#include "serialsettings.h"
 
 class PortDialog : public QDialog {
     Q_OBJECT
 public:
     explicit PortDialog(QWidget *parent = nullptr);
     QString selectedPort() const;
+    SampleDecoder::Kind selectedDecoder() const;
+    SerialSettings settings() const;
 
 private:
+    void loadSettings(const QString &portName);
+
     QComboBox *portComboBox;
+    QComboBox *baudComboBox;
+    QComboBox *dataBitsComboBox;
+    QComboBox *parityComboBox;
+    QComboBox *stopBitsComboBox;
+    QComboBox *flowControlComboBox;
+    QSpinBox *readBufferSpinBox;
+    QComboBox *decoderComboBox;
 };
 
 #endif // PORTDIALOG_H
@@ -0,0 +1,42 @@
+#ifndef PORTSESSION_H
+#define PORTSESSION_H
+
+#include <QDateTime>
+#include <QThread>
+
+#include "samplering.h"
+#include "serialreader.h"
+#include "serialsettings.h"
+#include "devicesimulator.h"
+#include "latencyhistogram.h"
+
+// One open serial port: its reader thread, the ring the reader fills for
+// the GUI and the one it fills for the capture writer while recording.
+// `device` is the stable id used to key this port's channel traces, -1
+// until the port has opened. A
+// session reading a simulator's pseudo terminal owns the simulator.
+struct PortSession {
+    explicit PortSession(int device) : device(device) {}
+
+    int device;
+    SerialSettings settings;
+    SampleRing<Sample> ring{1 << 16};
+    SampleRing<Sample> recordRing{1 << 18};
+    SerialReader *reader = nullptr;
+    QThread *thread = nullptr;
+    std::unique_ptr<PtySimulator> simulator;
+
+    // GUI-side bookkeeping for the Device Status window
+    quint64 reportedOverruns = 0;
+    quint64 lastSampleCount = 0;
+    quint64 lastByteCount = 0;
+    QDateTime lastUpdate;
+
+    // Read-to-frame latency while Measure Latency is on: `latency` covers
+    // the current status interval and is folded into `latencyTotal` after
+    // it is shown
+    LatencyHistogram latency;
+    LatencyHistogram latencyTotal;
+};
+
+#endif // PORTSESSION_H
@@ -0,0 +1,113 @@
+#include "renderscheduler.h"
+#include "tracing.h"
+#include <QElapsedTimer>
+
+RenderScheduler::RenderScheduler(QObject *parent)
+    : QObject(parent) {
+    timer = new QTimer(this);
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(1000 / fps);
+    connect(timer, &QTimer::timeout, this, &RenderScheduler::tick);
+}
+
+void RenderScheduler::setFrameRate(int hz) {
+    fps = qBound(1, hz, 240);
+    timer->setInterval(1000 / fps);
+}
+
+void RenderScheduler::addSource(int device, SampleRing<Sample> *ring) {
+    removeSource(device);
+    sources.push_back(Source{device, ring, {}, 0});
+}
+
+void RenderScheduler::removeSource(int device) {
+    for (auto it = sources.begin(); it != sources.end(); ++it) {
+        if (it->device == device) {
+            sources.erase(it);
+            return;
+        }
+    }
+}
+
+quint64 RenderScheduler::samplesDrained(int device) const {
+    for (const Source &source : sources) {
+        if (source.device == device)
+            return source.drained;
+    }
+    return 0;
+}
+
+RenderScheduler::FrameStats RenderScheduler::takeFrameStats() {
+    FrameStats taken = stats;
+    stats = FrameStats();
+    return taken;
+}
+
+void RenderScheduler::start() {
+    timer->start();
+}
+
+void RenderScheduler::stop() {
+    timer->stop();
+}
+
+void RenderScheduler::tick() {
+    TraceScope trace("RenderScheduler::frame");
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // The buffers keep their capacity between frames, so steady state does not allocate
+    {
+        TraceScope drain("RenderScheduler::drain");
+        for (Source &source : sources) {
+            source.pending.resize(int(source.ring->size()));
+            size_t n = source.ring->pop(source.pending.data(), size_t(source.pending.size()));
+            source.pending.resize(int(n));
+            for (Sample &sample : source.pending)
+                sample.device = quint16(source.device);
+            source.drained += n;
+        }
+    }
+
+    {
+        TraceScope merging("RenderScheduler::merge");
+        merge();
+    }
+    if (batch.isEmpty())
+        return;
+    Tracing::counter("frame samples", batch.size());
+    emit frameReady(batch);
+
+    const qint64 ns = elapsed.nsecsElapsed();
+    ++stats.frames;
+    stats.totalNs += ns;
+    stats.maxNs = qMax(stats.maxNs, ns);
+}
+
+void RenderScheduler::merge() {
+    batch.clear();
+    if (sources.size() == 1) {
+        batch.swap(sources.front().pending);
+        return;
+    }
+
+    // Each ring is already in time order, so a k-way merge on the head
+    // timestamps gives one time-ordered stream
+    qsizetype total = 0;
+    for (const Source &source : sources)
+        total += source.pending.size();
+    batch.reserve(total);
+
+    heads.assign(sources.size(), 0);
+    for (qsizetype i = 0; i < total; ++i) {
+        size_t best = sources.size();
+        for (size_t s = 0; s < sources.size(); ++s) {
+            if (heads[s] >= sources[s].pending.size())
+                continue;
+            if (best == sources.size()
+                || sources[s].pending[heads[s]].timestampNs < sources[best].pending[heads[best]].timestampNs)
+                best = s;
+        }
+        batch.append(sources[best].pending[heads[best]++]);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <vector>
+
+#include "samplering.h"
+
+// Drains every registered sample ring once per display frame, merges the
+// streams by timestamp and hands everything that arrived since the previous
+// frame to the chart as a single batch. Each sample is tagged with the
+// device id of the ring it came from.
+class RenderScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RenderScheduler(QObject *parent = nullptr);
+
+    void setFrameRate(int hz);
+    int frameRate() const { return fps; }
+
+    void addSource(int device, SampleRing<Sample> *ring);
+    void removeSource(int device);
+
+    // Samples drained from a device so far
+    quint64 samplesDrained(int device) const;
+
+    // Time spent on frames since the last call: draining, merging and the
+    // frameReady handlers
+    struct FrameStats {
+        int frames = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+    };
+    FrameStats takeFrameStats();
+
+    void start();
+    void stop();
+
+signals:
+    // Only emitted for frames that received at least one sample
+    void frameReady(const QVector<Sample> &batch);
+
+private:
+    struct Source {
+        int device;
+        SampleRing<Sample> *ring;
+        QVector<Sample> pending;
+        quint64 drained = 0;
+    };
+
+    void tick();
+    void merge();
+
+    std::vector<Source> sources;
+    QTimer *timer;
+    QVector<Sample> batch;
+    std::vector<qsizetype> heads;
+    int fps = 60;
+    FrameStats stats;
+};
+
+#endif // RENDERSCHEDULER_H
@@ -0,0 +1,31 @@
+#include "rollingminmax.h"
+
+RollingMinMax::RollingMinMax(int window) {
+    setWindow(window);
+}
+
+void RollingMinMax::setWindow(int window) {
+    windowSize = qMax(1, window);
+    clear();
+}
+
+void RollingMinMax::clear() {
+    minQueue.reset(size_t(windowSize));
+    maxQueue.reset(size_t(windowSize));
+    count = 0;
+}
+
+void RollingMinMax::add(double value) {
+    const qint64 index = count++;
+    const qint64 expired = index - windowSize;
+
+    // Drop entries that left the window, then entries the new value dominates
+    if (minQueue.size && minQueue.front().index <= expired) minQueue.popFront();
+    if (maxQueue.size && maxQueue.front().index <= expired) maxQueue.popFront();
+
+    while (minQueue.size && minQueue.back().value >= value) minQueue.popBack();
+    while (maxQueue.size && maxQueue.back().value <= value) maxQueue.popBack();
+
+    minQueue.pushBack(Entry{index, value});
+    maxQueue.pushBack(Entry{index, value});
+}
@@ -0,0 +1,50 @@
+#ifndef ROLLINGMINMAX_H
+#define ROLLINGMINMAX_H
+
+#include <QtGlobal>
+#include <vector>
+
+// Minimum and maximum over the last `window` values, maintained with two
+// monotonic queues: add() is amortised O(1) and min()/max() are O(1).
+// Both queues are preallocated to the window size, so adding never allocates.
+class RollingMinMax {
+public:
+    explicit RollingMinMax(int window = 100);
+
+    void setWindow(int window);   // clears the history
+    int window() const { return windowSize; }
+
+    void add(double value);
+    void clear();
+
+    bool isEmpty() const { return count == 0; }
+    double min() const { return minQueue.front().value; }
+    double max() const { return maxQueue.front().value; }
+
+private:
+    struct Entry {
+        qint64 index;
+        double value;
+    };
+
+    // Fixed-capacity deque over a ring buffer
+    struct MonotonicQueue {
+        std::vector<Entry> items;
+        size_t head = 0;
+        size_t size = 0;
+
+        void reset(size_t capacity) { items.assign(capacity, Entry{0, 0.0}); head = size = 0; }
+        const Entry &front() const { return items[head]; }
+        const Entry &back() const { return items[(head + size - 1) % items.size()]; }
+        void popFront() { head = (head + 1) % items.size(); --size; }
+        void popBack() { --size; }
+        void pushBack(const Entry &e) { items[(head + size) % items.size()] = e; ++size; }
+    };
+
+    MonotonicQueue minQueue;   // increasing values
+    MonotonicQueue maxQueue;   // decreasing values
+    int windowSize = 0;
+    qint64 count = 0;
+};
+
+#endif // ROLLINGMINMAX_H
@@ -0,0 +1,52 @@
+#include "samplebuffer.h"
+#include <atomic>
+
+SampleBuffer::SampleBuffer(qsizetype capacity) {
+    setCapacity(capacity);
+}
+
+void SampleBuffer::setCapacity(qsizetype capacity) {
+    cap = qMax<qsizetype>(1, capacity);
+    chunks.clear();
+    for (size_t first = 0; first < size_t(cap); first += ChunkMask + 1)
+        chunks.push_back(std::make_shared<Chunk>(qMin(ChunkMask + 1, size_t(cap) - first)));
+    count = 0;
+    end = 0;
+}
+
+void SampleBuffer::setOverflowPolicy(OverflowPolicy overflowPolicy, EvictionSink evictionSink) {
+    policy = overflowPolicy;
+    sink = std::move(evictionSink);
+}
+
+void SampleBuffer::append(const Sample &sample) {
+    const size_t index = size_t(end % cap);
+    std::shared_ptr<Chunk> &chunk = chunks[index >> ChunkShift];
+    if (chunk.use_count() > 1)
+        chunk = std::make_shared<Chunk>(*chunk);   // a snapshot still reads it
+    else
+        std::atomic_thread_fence(std::memory_order_acquire);   // pairs with a released snapshot's last read
+    Sample &slot = (*chunk)[index & ChunkMask];
+    if (count == cap) {
+        if (policy == OverflowPolicy::Forward && sink)
+            sink(end - cap, slot);
+    } else {
+        ++count;
+    }
+    slot = sample;
+    ++end;
+}
+
+SampleBuffer::Snapshot SampleBuffer::snapshot(qint64 first, qint64 last) const {
+    Snapshot snapshot;
+    snapshot.chunks.assign(chunks.begin(), chunks.end());
+    snapshot.cap = cap;
+    snapshot.first = qMax(first, firstIndex());
+    snapshot.end = qMax(snapshot.first, qMin(last, endIndex()));
+    return snapshot;
+}
+
+void SampleBuffer::clear(qint64 firstIndex) {
+    count = 0;
+    end = firstIndex;
+}
@@ -0,0 +1,81 @@
+#ifndef SAMPLEBUFFER_H
+#define SAMPLEBUFFER_H
+
+#include <QtGlobal>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "samplering.h"
+
+// Preallocated circular store for the most recent samples of a stream.
+// Samples are addressed by their absolute index since the start of the
+// capture; once the retention window is full the oldest sample is either
+// dropped or handed to an eviction sink (e.g. a recorder).
+//
+// The store is split into fixed-size chunks so snapshot() can hand another
+// thread an immutable view without copying samples; a chunk a snapshot
+// still holds is copied before it is next written.
+class SampleBuffer {
+    using Chunk = std::vector<Sample>;
+
+public:
+    enum class OverflowPolicy { Drop, Forward };
+    using EvictionSink = std::function<void(qint64 index, const Sample &sample)>;
+
+    class Snapshot {
+    public:
+        qint64 firstIndex() const { return first; }
+        qint64 endIndex() const { return end; }
+        qsizetype size() const { return qsizetype(end - first); }
+        bool isEmpty() const { return first == end; }
+        const Sample &at(qint64 index) const {
+            const size_t slot = size_t(index % cap);
+            return (*chunks[slot >> ChunkShift])[slot & ChunkMask];
+        }
+
+    private:
+        friend class SampleBuffer;
+        std::vector<std::shared_ptr<const Chunk>> chunks;
+        qsizetype cap = 1;
+        qint64 first = 0;
+        qint64 end = 0;
+    };
+
+    explicit SampleBuffer(qsizetype capacity = 1000000);
+
+    void setCapacity(qsizetype capacity);   // clears the buffer
+    void setOverflowPolicy(OverflowPolicy policy, EvictionSink sink = EvictionSink());
+
+    void append(const Sample &sample);
+    void clear(qint64 firstIndex = 0);    // the next sample gets firstIndex
+
+    // Absolute index range [firstIndex(), endIndex()) currently retained
+    qint64 firstIndex() const { return end - count; }
+    qint64 endIndex() const { return end; }
+    const Sample &at(qint64 index) const {
+        const size_t slot = size_t(index % cap);
+        return (*chunks[slot >> ChunkShift])[slot & ChunkMask];
+    }
+
+    // Samples [first, last) clamped to what is retained; safe to read from
+    // any thread while this buffer keeps growing
+    Snapshot snapshot(qint64 first, qint64 last) const;
+
+    qsizetype size() const { return count; }
+    qsizetype capacity() const { return cap; }
+    bool isEmpty() const { return count == 0; }
+
+private:
+    static const int ChunkShift = 14;     // 16384 samples, 256 KiB per chunk
+    static const size_t ChunkMask = (size_t(1) << ChunkShift) - 1;
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    qsizetype cap = 0;
+    qsizetype count = 0;
+    qint64 end = 0;
+    OverflowPolicy policy = OverflowPolicy::Drop;
+    EvictionSink sink;
+};
+
+#endif // SAMPLEBUFFER_H
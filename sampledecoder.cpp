@@ -0,0 +1,115 @@
+#include "sampledecoder.h"
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+std::unique_ptr<SampleDecoder> SampleDecoder::create(Kind kind) {
+    if (kind == Kind::BinaryFrames)
+        return std::make_unique<BinaryFrameDecoder>();
+    return std::make_unique<LineDecoder>();
+}
+
+
+qsizetype LineDecoder::decode(const char *data, qsizetype size, qint64 timestampNs,
+                              SampleRing<Sample> &ring) {
+    const char *pos = data;
+    const char *end = data + size;
+
+    while (pos < end) {
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', size_t(end - pos)));
+        if (!newline)
+            break;
+
+        // Fields are parsed in place; no QByteArray per line or per field
+        const bool ok = parseLine(pos, newline, [&](quint16 channel, double value) {
+            publish(ring, Sample{timestampNs, value, channel});
+        });
+        if (!ok)
+            ++errors;
+        pos = newline + 1;
+    }
+    return pos - data;
+}
+
+quint16 BinaryFrameDecoder::crc16(const quint8 *data, qsizetype size) {
+    static const auto table = [] {
+        std::array<quint16, 256> t{};
+        for (int i = 0; i < 256; ++i) {
+            quint16 crc = quint16(i << 8);
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 0x8000) ? quint16((crc << 1) ^ 0x1021) : quint16(crc << 1);
+            t[size_t(i)] = crc;
+        }
+        return t;
+    }();
+
+    quint16 crc = 0xFFFF;
+    for (qsizetype i = 0; i < size; ++i)
+        crc = quint16((crc << 8) ^ table[size_t(((crc >> 8) ^ data[i]) & 0xFF)]);
+    return crc;
+}
+
+qsizetype BinaryFrameDecoder::decode(const char *data, qsizetype size, qint64 timestampNs,
+                                     SampleRing<Sample> &ring) {
+    const quint8 *bytes = reinterpret_cast<const quint8 *>(data);
+    qsizetype pos = 0;
+    const qsizetype headerSize = 5;
+
+    while (size - pos >= headerSize) {
+        // Resync: skip anything that is not the start of a frame
+        if (bytes[pos] != Sync0 || bytes[pos + 1] != Sync1) {
+            const void *next = std::memchr(bytes + pos + 1, Sync0, size_t(size - pos - 1));
+            pos = next ? static_cast<const quint8 *>(next) - bytes : size;
+            ++errors;
+            continue;
+        }
+
+        const quint8 channel = bytes[pos + 3];
+        const quint8 type = bytes[pos + 4];
+        qsizetype payloadSize;
+        if (type == Int16)
+            payloadSize = 2;
+        else if (type == Float32)
+            payloadSize = 4;
+        else {
+            ++errors;
+            pos += 1;
+            continue;
+        }
+
+        const qsizetype frameSize = headerSize + payloadSize + 2;
+        if (size - pos < frameSize)
+            break;
+
+        const quint8 *frame = bytes + pos;
+        const quint16 crc = qFromLittleEndian<quint16>(frame + headerSize + payloadSize);
+        if (crc != crc16(frame + 2, headerSize - 2 + payloadSize)) {
+            // Corrupt frame or a false sync inside payload data
+            ++crcFailures;
+            pos += 1;
+            continue;
+        }
+
+        double value;
+        if (type == Int16) {
+            value = qFromLittleEndian<qint16>(frame + headerSize);
+        } else {
+            const quint32 raw = qFromLittleEndian<quint32>(frame + headerSize);
+            float f;
+            std::memcpy(&f, &raw, sizeof(f));
+            value = f;
+        }
+
+        const quint8 sequence = frame[2];
+        if (haveSequence)
+            gaps += quint8(sequence - lastSequence - 1);
+        lastSequence = sequence;
+        haveSequence = true;
+
+        Sample sample{timestampNs, value};
+        sample.channel = channel;
+        publish(ring, sample);
+        pos += frameSize;
+    }
+    return pos;
+}
@@ -0,0 +1,115 @@
+#ifndef SAMPLEDECODER_H
+#define SAMPLEDECODER_H
+
+#include <QtGlobal>
+#include <charconv>
+#include <memory>
+
+#include "samplering.h"
+
+// Turns raw bytes from a serial port into samples. Decoders work directly on
+// the reader's receive buffer and return how many bytes they consumed; the
+// unconsumed tail (a partial line or frame) is presented again next time.
+class SampleDecoder {
+public:
+    enum class Kind { TextLines, BinaryFrames };
+
+    virtual ~SampleDecoder() = default;
+
+    virtual qsizetype decode(const char *data, qsizetype size, qint64 timestampNs,
+                             SampleRing<Sample> &ring) = 0;
+
+    // Every decoded sample is also pushed into `ring` (nullptr for none)
+    void setTee(SampleRing<Sample> *ring) { tee = ring; }
+
+    quint64 parseErrors() const { return errors; }
+    quint64 crcErrors() const { return crcFailures; }
+    // Frames the device numbered but that never arrived intact
+    quint64 sequenceGaps() const { return gaps; }
+
+    static std::unique_ptr<SampleDecoder> create(Kind kind);
+
+protected:
+    void publish(SampleRing<Sample> &ring, const Sample &sample) {
+        ring.push(sample);
+        if (tee) tee->push(sample);
+    }
+
+    quint64 errors = 0;
+    quint64 crcFailures = 0;
+    quint64 gaps = 0;
+    SampleRing<Sample> *tee = nullptr;
+};
+
+// Newline-delimited ASCII numbers. A line may carry several channels
+// separated by commas, semicolons, tabs or spaces; field N becomes channel N.
+class LineDecoder : public SampleDecoder {
+public:
+    qsizetype decode(const char *data, qsizetype size, qint64 timestampNs,
+                     SampleRing<Sample> &ring) override;
+
+    static constexpr int MaxFields = 256;
+
+    // Parses the fields of one line in place into values[0..MaxFields).
+    // Returns the field count, or -1 if a field is not a number or the line
+    // has more than MaxFields fields.
+    static int parseFields(const char *field, const char *last, double *values) {
+        int count = 0;
+        for (;;) {
+            while (field < last && isSpace(*field)) ++field;
+            if (field == last)
+                return count;
+            if (count == MaxFields)
+                return -1;
+            if (*field == '+') ++field;
+
+            auto result = std::from_chars(field, last, values[count]);
+            if (result.ec != std::errc())
+                return -1;
+            ++count;
+
+            field = result.ptr;
+            while (field < last && isSpace(*field)) ++field;
+            if (field < last && (*field == ',' || *field == ';')) ++field;
+        }
+    }
+
+    // Calls onField(channel, value) for each field of a line, but only once
+    // the whole line has parsed, so a bad line yields no samples at all.
+    // Returns false for a bad line.
+    template <typename Callback>
+    static bool parseLine(const char *field, const char *last, Callback &&onField) {
+        double values[MaxFields];
+        const int count = parseFields(field, last, values);
+        for (int channel = 0; channel < count; ++channel)
+            onField(quint16(channel), values[channel]);
+        return count >= 0;
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+};
+
+// Binary frames, all fields little-endian:
+//   0xA5 0x5A | seq u8 | channel u8 | type u8 | payload | crc16 u16
+// type 0 is an int16 payload, type 1 a float32 payload. The CRC is
+// CRC-16/CCITT-FALSE over seq..payload. seq counts frames modulo 256, so a
+// jump in it is counted as that many lost frames.
+class BinaryFrameDecoder : public SampleDecoder {
+public:
+    static constexpr quint8 Sync0 = 0xA5;
+    static constexpr quint8 Sync1 = 0x5A;
+    enum PayloadType : quint8 { Int16 = 0, Float32 = 1 };
+
+    qsizetype decode(const char *data, qsizetype size, qint64 timestampNs,
+                     SampleRing<Sample> &ring) override;
+
+    static quint16 crc16(const quint8 *data, qsizetype size);
+
+private:
+    quint8 lastSequence = 0;
+    bool haveSequence = false;
+};
+
+#endif // SAMPLEDECODER_H
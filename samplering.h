@@ -0,0 +1,84 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Timestamped value as produced by the serial reader thread.
+struct Sample {
+    qint64 timestampNs = 0;   // steady clock, taken when the bytes were read
+    double value = 0.0;
+    quint16 channel = 0;
+    quint16 device = 0;       // set by the scheduler when streams are merged
+};
+
+// Clock used for Sample::timestampNs
+inline qint64 steadyClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Fixed-capacity lock-free ring for exactly one producer thread and one
+// consumer thread. When the consumer falls behind, new items are dropped and
+// counted as overruns instead of blocking the producer.
+template <typename T>
+class SampleRing {
+public:
+    explicit SampleRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    SampleRing(const SampleRing &) = delete;
+    SampleRing &operator=(const SampleRing &) = delete;
+
+    // Producer side
+    bool push(const T &item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail > mask) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail > mask) {
+                overrunCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        buffer[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: copies up to maxItems into out, returns the count.
+    size_t pop(T *out, size_t maxItems) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t available = head.load(std::memory_order_acquire) - t;
+        const size_t n = available < maxItems ? available : maxItems;
+        for (size_t i = 0; i < n; ++i)
+            out[i] = buffer[(t + i) & mask];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return mask + 1; }
+    quint64 pushed() const { return head.load(std::memory_order_relaxed); }
+    quint64 overruns() const { return overrunCount.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> buffer;
+    size_t mask = 0;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<quint64> overrunCount{0};
+};
+
+#endif // SAMPLERING_H
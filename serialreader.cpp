@@ -0,0 +1,148 @@
+#include "serialreader.h"
+#include "tracing.h"
+#include <QDebug>
+#include <cstring>
+
+SerialReader::SerialReader(SampleRing<Sample> *ring, QObject *parent)
+    : QObject(parent), ring(ring) {
+    readBuffer.resize(64 * 1024);
+}
+
+SerialReader::~SerialReader() {
+    closePort();
+}
+
+void SerialReader::reset(SampleDecoder::Kind kind) {
+    decoder = SampleDecoder::create(kind);
+    decoder->setTee(recordRing);
+    pending = 0;
+    parseErrorCount.store(0, std::memory_order_relaxed);
+    crcErrorCount.store(0, std::memory_order_relaxed);
+    byteCount.store(0, std::memory_order_relaxed);
+    gapCount.store(0, std::memory_order_relaxed);
+}
+
+void SerialReader::setRecordRing(SampleRing<Sample> *ring) {
+    recordRing = ring;
+    if (decoder)
+        decoder->setTee(recordRing);
+}
+
+bool SerialReader::openPort(const SerialSettings &settings) {
+    closePort();
+    reset(settings.decoder);
+
+    // Created lazily so the port lives on the reader thread
+    if (!serial) {
+        serial = new QSerialPort(this);
+        connect(serial, &QSerialPort::readyRead, this, &SerialReader::readAvailable);
+    }
+
+    serial->setPortName(settings.portName);
+    serial->setBaudRate(settings.baudRate);
+    serial->setDataBits(settings.dataBits);
+    serial->setParity(settings.parity);
+    serial->setStopBits(settings.stopBits);
+    serial->setFlowControl(settings.flowControl);
+    serial->setReadBufferSize(settings.readBufferSize);
+
+    if (!serial->open(QIODevice::ReadOnly)) {
+        errorText = serial->errorString();
+        return false;
+    }
+
+    errorText.clear();
+    portOpen.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool SerialReader::openSimulator(const SimulatorSettings &settings) {
+    closePort();
+    reset(settings.framing);
+    generator = std::make_unique<SignalGenerator>(settings);
+
+    // Created lazily so the timer lives on the reader thread
+    if (!generatorTimer) {
+        generatorTimer = new QTimer(this);
+        generatorTimer->setTimerType(Qt::PreciseTimer);
+        generatorTimer->setInterval(1);
+        connect(generatorTimer, &QTimer::timeout, this, &SerialReader::generateAvailable);
+    }
+    generatorStartNs = steadyClockNs();
+    generatorTimer->start();
+
+    errorText.clear();
+    portOpen.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void SerialReader::closePort() {
+    if (serial && serial->isOpen()) {
+        serial->close();
+        portOpen.store(false, std::memory_order_relaxed);
+        emit portClosed();
+    }
+    if (generator) {
+        generatorTimer->stop();
+        generator.reset();
+        portOpen.store(false, std::memory_order_relaxed);
+        emit portClosed();
+    }
+}
+
+void SerialReader::readAvailable() {
+    TraceScope trace("SerialReader::read");
+    const qint64 now = steadyClockNs();
+    quint64 bytes = 0;
+
+    for (;;) {
+        qint64 n = serial->read(readBuffer.data() + pending, readBuffer.size() - pending);
+        if (n <= 0)
+            break;
+        pending += qsizetype(n);
+        bytes += quint64(n);
+        decodePending(now);
+    }
+    publishCounters(bytes);
+}
+
+void SerialReader::generateAvailable() {
+    TraceScope trace("SerialReader::generate");
+    const qint64 now = steadyClockNs();
+    qint64 due = generator->samplesDue(now - generatorStartNs);
+    quint64 bytes = 0;
+
+    // What does not fit into the buffer now is generated on the next tick
+    while (due > 0) {
+        const qsizetype n = generator->generate(readBuffer.data() + pending, readBuffer.size() - pending, due);
+        if (n == 0)
+            break;
+        pending += n;
+        bytes += quint64(n);
+        decodePending(now);
+    }
+    publishCounters(bytes);
+}
+
+void SerialReader::decodePending(qint64 timestampNs) {
+    TraceScope trace("SerialReader::parse");
+    char *buffer = readBuffer.data();
+    qsizetype consumed = decoder->decode(buffer, pending, timestampNs, *ring);
+    if (consumed == 0 && pending == readBuffer.size()) {
+        // A record longer than the whole buffer is garbage; start over
+        consumed = pending;
+    }
+    pending -= consumed;
+    if (pending > 0 && consumed > 0)
+        std::memmove(buffer, buffer + consumed, size_t(pending));
+}
+
+void SerialReader::publishCounters(quint64 bytes) {
+    Tracing::counter("bytes read", qint64(bytes));
+
+    // This thread is the only writer, so a plain store is enough
+    byteCount.store(byteCount.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    parseErrorCount.store(decoder->parseErrors(), std::memory_order_relaxed);
+    crcErrorCount.store(decoder->crcErrors(), std::memory_order_relaxed);
+    gapCount.store(decoder->sequenceGaps(), std::memory_order_relaxed);
+}
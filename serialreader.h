@@ -0,0 +1,70 @@
+#ifndef SERIALREADER_H
+#define SERIALREADER_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QTimer>
+#include <atomic>
+
+#include "samplering.h"
+#include "sampledecoder.h"
+#include "serialsettings.h"
+#include "devicesimulator.h"
+
+// Owns the QSerialPort and decodes incoming bytes on its own thread. Decoded
+// samples are pushed into a SampleRing that the GUI drains on its own
+// schedule, so a busy GUI thread never stalls the port. Instead of a port,
+// the reader can decode the stream of a simulated device generated on the
+// same thread, which exercises the whole ingestion path without hardware.
+// While recording, decoded samples are also pushed into a second ring the
+// capture writer drains, so a recording does not depend on the GUI keeping
+// up.
+class SerialReader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SerialReader(SampleRing<Sample> *ring, QObject *parent = nullptr);
+    ~SerialReader();
+
+    bool isOpen() const { return portOpen.load(std::memory_order_relaxed); }
+    QString lastError() const { return errorText; }
+    quint64 parseErrors() const { return parseErrorCount.load(std::memory_order_relaxed); }
+    quint64 crcErrors() const { return crcErrorCount.load(std::memory_order_relaxed); }
+    quint64 bytesRead() const { return byteCount.load(std::memory_order_relaxed); }
+    quint64 sequenceGaps() const { return gapCount.load(std::memory_order_relaxed); }
+
+public slots:
+    // Must run on the reader thread (use a queued/blocking invoke)
+    bool openPort(const SerialSettings &settings);
+    bool openSimulator(const SimulatorSettings &settings);
+    void closePort();
+    void setRecordRing(SampleRing<Sample> *ring);   // nullptr stops recording
+
+signals:
+    void portClosed();
+
+private:
+    void reset(SampleDecoder::Kind kind);
+    void readAvailable();
+    void generateAvailable();
+    void decodePending(qint64 timestampNs);
+    void publishCounters(quint64 bytes);
+
+    SampleRing<Sample> *ring;
+    SampleRing<Sample> *recordRing = nullptr;
+    QSerialPort *serial = nullptr;
+    std::unique_ptr<SignalGenerator> generator;
+    QTimer *generatorTimer = nullptr;
+    qint64 generatorStartNs = 0;
+    std::unique_ptr<SampleDecoder> decoder;
+    QByteArray readBuffer;          // fixed size, decoded in place
+    qsizetype pending = 0;          // undecoded bytes at the front of readBuffer
+    QString errorText;
+    std::atomic<bool> portOpen{false};
+    std::atomic<quint64> parseErrorCount{0};
+    std::atomic<quint64> crcErrorCount{0};
+    std::atomic<quint64> byteCount{0};
+    std::atomic<quint64> gapCount{0};
+};
+
+#endif // SERIALREADER_H
@@ -0,0 +1,44 @@
+#include "serialsettings.h"
+#include <QSettings>
+
+static QString groupFor(const QString &portName) {
+    // Port names such as /dev/ttyUSB0 contain slashes, which QSettings treats as groups
+    QString key = portName;
+    key.replace('/', '_');
+    return "serial/ports/" + key;
+}
+
+SerialSettings SerialSettings::load(const QString &portName) {
+    SerialSettings s;
+    s.portName = portName;
+
+    QSettings settings;
+    settings.beginGroup(groupFor(portName));
+    s.baudRate = settings.value("baudRate", s.baudRate).toInt();
+    s.dataBits = QSerialPort::DataBits(settings.value("dataBits", int(s.dataBits)).toInt());
+    s.parity = QSerialPort::Parity(settings.value("parity", int(s.parity)).toInt());
+    s.stopBits = QSerialPort::StopBits(settings.value("stopBits", int(s.stopBits)).toInt());
+    s.flowControl = QSerialPort::FlowControl(settings.value("flowControl", int(s.flowControl)).toInt());
+    s.readBufferSize = settings.value("readBufferSize", s.readBufferSize).toLongLong();
+    s.decoder = SampleDecoder::Kind(settings.value("decoder", int(s.decoder)).toInt());
+    settings.endGroup();
+    return s;
+}
+
+void SerialSettings::save() const {
+    QSettings settings;
+    settings.beginGroup(groupFor(portName));
+    settings.setValue("baudRate", baudRate);
+    settings.setValue("dataBits", int(dataBits));
+    settings.setValue("parity", int(parity));
+    settings.setValue("stopBits", int(stopBits));
+    settings.setValue("flowControl", int(flowControl));
+    settings.setValue("readBufferSize", readBufferSize);
+    settings.setValue("decoder", int(decoder));
+    settings.endGroup();
+    settings.setValue("serial/lastPort", portName);
+}
+
+QString SerialSettings::lastPortName() {
+    return QSettings().value("serial/lastPort").toString();
+}
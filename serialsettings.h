@@ -0,0 +1,27 @@
+#ifndef SERIALSETTINGS_H
+#define SERIALSETTINGS_H
+
+#include <QSerialPort>
+#include <QString>
+
+#include "sampledecoder.h"
+
+// Everything needed to open one serial port. Stored per port name in
+// QSettings so reconnecting restores the last configuration.
+struct SerialSettings {
+    QString portName;
+    qint32 baudRate = QSerialPort::Baud9600;
+    QSerialPort::DataBits dataBits = QSerialPort::Data8;
+    QSerialPort::Parity parity = QSerialPort::NoParity;
+    QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+    QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+    qint64 readBufferSize = 0;   // 0 = unlimited
+    SampleDecoder::Kind decoder = SampleDecoder::Kind::TextLines;
+
+    static SerialSettings load(const QString &portName);
+    void save() const;
+
+    static QString lastPortName();
+};
+
+#endif // SERIALSETTINGS_H
@@ -0,0 +1,96 @@
+#include "simulatordialog.h"
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QVBoxLayout>
+
+SimulatorDialog::SimulatorDialog(QWidget *parent) : QDialog(parent) {
+    setWindowTitle("Open Simulated Device");
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QFormLayout *form = new QFormLayout;
+
+    outputComboBox = new QComboBox(this);
+    outputComboBox->addItem("Direct (no port)", int(SimulatorSettings::Output::Direct));
+#ifdef Q_OS_UNIX
+    outputComboBox->addItem("Pseudo terminal", int(SimulatorSettings::Output::PseudoTerminal));
+#endif
+    form->addRow("Output:", outputComboBox);
+
+    framingComboBox = new QComboBox(this);
+    framingComboBox->addItem("Text lines", int(SampleDecoder::Kind::TextLines));
+    framingComboBox->addItem("Binary frames", int(SampleDecoder::Kind::BinaryFrames));
+    form->addRow("Protocol:", framingComboBox);
+
+    waveformComboBox = new QComboBox(this);
+    waveformComboBox->addItem("Sine", int(SimulatorSettings::Waveform::Sine));
+    waveformComboBox->addItem("Square", int(SimulatorSettings::Waveform::Square));
+    waveformComboBox->addItem("Sawtooth", int(SimulatorSettings::Waveform::Sawtooth));
+    waveformComboBox->addItem("Noise", int(SimulatorSettings::Waveform::Noise));
+    form->addRow("Waveform:", waveformComboBox);
+
+    rateSpinBox = new QSpinBox(this);
+    rateSpinBox->setRange(1, 10000000);
+    rateSpinBox->setSuffix(" samples/s");
+    form->addRow("Rate:", rateSpinBox);
+
+    channelsSpinBox = new QSpinBox(this);
+    channelsSpinBox->setRange(1, 256);
+    form->addRow("Channels:", channelsSpinBox);
+
+    amplitudeSpinBox = new QDoubleSpinBox(this);
+    amplitudeSpinBox->setRange(0, 1e9);
+    form->addRow("Amplitude:", amplitudeSpinBox);
+
+    frequencySpinBox = new QDoubleSpinBox(this);
+    frequencySpinBox->setRange(0, 1e6);
+    frequencySpinBox->setSuffix(" Hz");
+    form->addRow("Frequency:", frequencySpinBox);
+
+    noiseSpinBox = new QDoubleSpinBox(this);
+    noiseSpinBox->setRange(0, 1e9);
+    form->addRow("Noise (std. dev.):", noiseSpinBox);
+
+    corruptionSpinBox = new QDoubleSpinBox(this);
+    corruptionSpinBox->setRange(0, 100);
+    corruptionSpinBox->setDecimals(3);
+    corruptionSpinBox->setSuffix(" % of records");
+    form->addRow("Corruption:", corruptionSpinBox);
+
+    seedSpinBox = new QSpinBox(this);
+    seedSpinBox->setRange(0, 2147483647);
+    form->addRow("Seed:", seedSpinBox);
+
+    layout->addLayout(form);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    const SimulatorSettings s = SimulatorSettings::load();
+    outputComboBox->setCurrentIndex(qMax(0, outputComboBox->findData(int(s.output))));
+    framingComboBox->setCurrentIndex(framingComboBox->findData(int(s.framing)));
+    waveformComboBox->setCurrentIndex(waveformComboBox->findData(int(s.waveform)));
+    rateSpinBox->setValue(int(s.samplesPerSecond));
+    channelsSpinBox->setValue(s.channels);
+    amplitudeSpinBox->setValue(s.amplitude);
+    frequencySpinBox->setValue(s.frequencyHz);
+    noiseSpinBox->setValue(s.noise);
+    corruptionSpinBox->setValue(s.corruption * 100);
+    seedSpinBox->setValue(int(s.seed));
+}
+
+SimulatorSettings SimulatorDialog::settings() const {
+    SimulatorSettings s;
+    s.output = SimulatorSettings::Output(outputComboBox->currentData().toInt());
+    s.framing = SampleDecoder::Kind(framingComboBox->currentData().toInt());
+    s.waveform = SimulatorSettings::Waveform(waveformComboBox->currentData().toInt());
+    s.samplesPerSecond = rateSpinBox->value();
+    s.channels = channelsSpinBox->value();
+    s.amplitude = amplitudeSpinBox->value();
+    s.frequencyHz = frequencySpinBox->value();
+    s.noise = noiseSpinBox->value();
+    s.corruption = corruptionSpinBox->value() / 100;
+    s.seed = quint32(seedSpinBox->value());
+    return s;
+}
@@ -0,0 +1,31 @@
+#ifndef SIMULATORDIALOG_H
+#define SIMULATORDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+
+#include "devicesimulator.h"
+
+// Load profile of a simulated device, restored from the last run
+class SimulatorDialog : public QDialog {
+    Q_OBJECT
+public:
+    explicit SimulatorDialog(QWidget *parent = nullptr);
+    SimulatorSettings settings() const;
+
+private:
+    QComboBox *outputComboBox;
+    QComboBox *framingComboBox;
+    QComboBox *waveformComboBox;
+    QSpinBox *rateSpinBox;
+    QSpinBox *channelsSpinBox;
+    QDoubleSpinBox *amplitudeSpinBox;
+    QDoubleSpinBox *frequencySpinBox;
+    QDoubleSpinBox *noiseSpinBox;
+    QDoubleSpinBox *corruptionSpinBox;
+    QSpinBox *seedSpinBox;
+};
+
+#endif // SIMULATORDIALOG_H
@@ -0,0 +1,190 @@
+#include "textimporter.h"
+#include "sampledecoder.h"
+#include "tracing.h"
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// Chunks smaller than this are not worth a thread of their own
+static const qint64 MinChunkBytes = 1 << 20;
+static const qint64 ProgressStepBytes = 1 << 20;
+
+// Runs job(0) .. job(count - 1) on up to `threads` threads, the calling one included
+template <typename Job>
+static void runParallel(size_t count, int threads, Job job) {
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;)
+            job(i);
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < qMin(count, size_t(threads)); ++t)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &thread : pool)
+        thread.join();
+}
+
+// Field count of the first line that parses and is not blank
+static int firstRowWidth(const char *pos, const char *end) {
+    double values[LineDecoder::MaxFields];
+    while (pos < end) {
+        const void *found = std::memchr(pos, '\n', size_t(end - pos));
+        const char *newline = found ? static_cast<const char *>(found) : end;
+        const int count = LineDecoder::parseFields(pos, newline, values);
+        if (count > 0)
+            return count;
+        pos = newline + 1;
+    }
+    return 0;
+}
+
+TextImporter::TextImporter(const QString &fileName, qsizetype retention, QObject *parent)
+    : QObject(parent), path(fileName), retention(retention),
+      threads(qMax(1, int(std::thread::hardware_concurrency()))) {}
+
+TextImporter::~TextImporter() {
+    cancel();
+    if (worker) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void TextImporter::start() {
+    if (worker) return;
+    worker = QThread::create([this]() { emit finished(importNow()); });
+    worker->setObjectName("Text Import");
+    worker->start();
+}
+
+bool TextImporter::importNow() {
+    TraceScope trace("TextImporter::import");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorText = file.errorString();
+        return false;
+    }
+
+    const qint64 size = file.size();
+    const char *data = nullptr;
+    if (size > 0) {
+        data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            errorText = file.errorString();
+            return false;
+        }
+    }
+
+    width = firstRowWidth(data, data + size);
+
+    // Chunks end just after a newline, so no line is split between threads
+    const qint64 chunkCount = qBound<qint64>(1, size / MinChunkBytes, threads * 4);
+    const char *end = data + size;
+    std::vector<Chunk> chunks;
+    const char *first = data;
+    for (qint64 i = 1; i <= chunkCount && first < end; ++i) {
+        const char *last = i == chunkCount ? end : qMax(first, data + size * i / chunkCount);
+        if (last < end) {
+            const void *newline = std::memchr(last, '\n', size_t(end - last));
+            last = newline ? static_cast<const char *>(newline) + 1 : end;
+        }
+        chunks.push_back(Chunk{first, last, std::vector<std::vector<double>>(size_t(width))});
+        first = last;
+    }
+
+    int lastPercent = -1;
+    auto report = [&](int percent) {
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progressChanged(percent);
+        }
+    };
+
+    // Parsing takes the first 90% of the progress range; the workers only
+    // bump a counter and this thread turns it into progress signals
+    std::atomic<bool> parsed{false};
+    std::thread parser([&]() {
+        runParallel(chunks.size(), threads, [&](size_t i) { parseChunk(chunks[i]); });
+        parsed.store(true, std::memory_order_release);
+    });
+    while (!parsed.load(std::memory_order_acquire)) {
+        report(size ? int(bytesParsed.load(std::memory_order_relaxed) * 90 / size) : 90);
+        QThread::msleep(50);
+    }
+    parser.join();
+
+    if (canceled.load(std::memory_order_relaxed))
+        return false;
+
+    for (const Chunk &chunk : chunks) {
+        errors += chunk.errors;
+        rows += chunk.rows;
+    }
+
+    // Each column's pyramid has to be built in order, but the columns are independent
+    result.clear();
+    result.resize(size_t(width));
+    runParallel(size_t(width), threads, [&](size_t column) { buildColumn(chunks, column); });
+    report(100);
+
+    return !canceled.load(std::memory_order_relaxed);
+}
+
+void TextImporter::parseChunk(Chunk &chunk) {
+    const char *pos = chunk.first;
+    const char *reported = pos;
+    double values[LineDecoder::MaxFields];
+    while (pos < chunk.last) {
+        const void *found = std::memchr(pos, '\n', size_t(chunk.last - pos));
+        const char *newline = found ? static_cast<const char *>(found) : chunk.last;
+
+        // A row is taken whole or not at all, so the columns stay aligned
+        const int count = LineDecoder::parseFields(pos, newline, values);
+        if (count == width) {
+            for (int column = 0; column < count; ++column)
+                chunk.columns[size_t(column)].push_back(values[column]);
+            ++chunk.rows;
+        } else if (count != 0) {
+            ++chunk.errors;
+        }
+        pos = newline + 1;
+
+        if (pos - reported >= ProgressStepBytes) {
+            bytesParsed.fetch_add(pos - reported, std::memory_order_relaxed);
+            reported = pos;
+            if (canceled.load(std::memory_order_relaxed))
+                return;
+        }
+    }
+    bytesParsed.fetch_add(qMin(pos, chunk.last) - reported, std::memory_order_relaxed);
+}
+
+void TextImporter::buildColumn(std::vector<Chunk> &chunks, size_t index) {
+    Column &column = result[index];
+    bool first = true;
+    for (const Chunk &chunk : chunks) {
+        for (double value : chunk.columns[index]) {
+            column.decimation.append(value);
+            column.min = first ? value : qMin(column.min, value);
+            column.max = first ? value : qMax(column.max, value);
+            first = false;
+        }
+        column.count += qint64(chunk.columns[index].size());
+    }
+
+    // Keep the retention tail, then release the parsed values
+    const qint64 keep = qMin<qint64>(retention, column.count);
+    column.tail.resize(size_t(keep));
+    qint64 remaining = keep;
+    for (auto chunk = chunks.rbegin(); chunk != chunks.rend() && remaining > 0; ++chunk) {
+        const std::vector<double> &values = chunk->columns[index];
+        const qint64 n = qMin<qint64>(remaining, qint64(values.size()));
+        std::copy(values.end() - n, values.end(), column.tail.begin() + (remaining - n));
+        remaining -= n;
+    }
+    for (Chunk &chunk : chunks)
+        std::vector<double>().swap(chunk.columns[index]);
+}
@@ -0,0 +1,80 @@
+#ifndef TEXTIMPORTER_H
+#define TEXTIMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#include "decimationpyramid.h"
+
+// Imports a newline-delimited text or CSV log in the same format the serial
+// LineDecoder accepts. The file is memory-mapped, cut into newline-aligned
+// chunks and parsed on all cores; the columns are then summarised into the
+// decimation pyramids the Data View draws from. Only the last `retention`
+// raw values of each column are kept, as for a live stream. The first
+// numeric row sets the column count; rows that do not parse or have a
+// different width are skipped whole, so every column has one value per row.
+class TextImporter : public QObject {
+    Q_OBJECT
+
+public:
+    struct Column {
+        DecimationPyramid decimation;
+        std::vector<double> tail;     // last values of the column, oldest first
+        qint64 count = 0;             // values in the whole column
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    TextImporter(const QString &fileName, qsizetype retention, QObject *parent = nullptr);
+    ~TextImporter();
+
+    void start();
+    void setThreadCount(int count) { threads = qMax(1, count); }
+    void cancel() { canceled.store(true, std::memory_order_relaxed); }   // thread-safe
+
+    QString fileName() const { return path; }
+    QString errorString() const { return errorText; }
+    quint64 parseErrors() const { return errors; }
+    qint64 rowCount() const { return rows; }
+
+    // Imports synchronously on the calling thread; start() runs this on a worker
+    bool importNow();
+
+    // Valid once the import has succeeded
+    std::vector<Column> &columns() { return result; }
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool ok);
+
+private:
+    struct Chunk {
+        const char *first;
+        const char *last;
+        std::vector<std::vector<double>> columns;
+        quint64 errors = 0;
+        qint64 rows = 0;
+    };
+
+    void parseChunk(Chunk &chunk);
+    void buildColumn(std::vector<Chunk> &chunks, size_t column);
+
+    QString path;
+    qsizetype retention;
+    int threads;
+    QThread *worker = nullptr;
+    int width = 0;                  // fields in every accepted row
+    std::atomic<bool> canceled{false};
+    std::atomic<qint64> bytesParsed{0};
+
+    // Written by the worker, read after finished()
+    std::vector<Column> result;
+    QString errorText;
+    quint64 errors = 0;
+    qint64 rows = 0;
+};
+
+#endif // TEXTIMPORTER_H
@@ -0,0 +1,235 @@
+#include "traceplotwidget.h"
+#include "chartrenderer.h"
+#include "tracing.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <cmath>
+#include <cstring>
+
+static const int LeftMargin = 56;
+static const int RightMargin = 8;
+static const int TopMargin = 8;
+static const int BottomMargin = 22;
+
+TracePlotWidget::TracePlotWidget(QWidget *parent)
+    : QWidget(parent) {
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(LeftMargin + RightMargin + 32, TopMargin + BottomMargin + 32);
+}
+
+int TracePlotWidget::addTrace(const QColor &color) {
+    Trace trace;
+    trace.color = color;
+    trace.values.resize(ringSize());
+    traces.push_back(std::move(trace));
+    return int(traces.size()) - 1;
+}
+
+void TracePlotWidget::setTraceVisible(int trace, bool visible) {
+    if (trace < 0 || trace >= int(traces.size())) return;
+    traces[size_t(trace)].visible = visible;
+    cacheValid = false;
+    update();
+}
+
+void TracePlotWidget::restartTrace(int trace, qint64 firstIndex) {
+    if (trace < 0 || trace >= int(traces.size())) return;
+    Trace &t = traces[size_t(trace)];
+    t.first = t.end = t.drawnEnd = firstIndex;
+    cacheValid = false;
+}
+
+void TracePlotWidget::setSpan(qint64 samples) {
+    samples = qMax<qint64>(2, samples);
+    if (samples == visibleSpan) return;
+    visibleSpan = samples;
+    for (Trace &trace : traces)
+        resizeRing(trace);
+    cacheValid = false;
+    update();
+}
+
+void TracePlotWidget::setYRange(double min, double max) {
+    if (min == yMin && max == yMax) return;
+    yMin = min;
+    yMax = max > min ? max : min + 1;
+    cacheValid = false;
+    update();
+}
+
+void TracePlotWidget::append(int trace, float value) {
+    Trace &t = traces[size_t(trace)];
+    const qint64 n = qint64(t.values.size());
+    t.values[size_t(t.end % n)] = value;
+    ++t.end;
+    if (t.end - t.first > n)
+        t.first = t.end - n;
+}
+
+QRect TracePlotWidget::plotRect() const {
+    return rect().adjusted(LeftMargin, TopMargin, -RightMargin, -BottomMargin);
+}
+
+qint64 TracePlotWidget::columnOf(qint64 index) const {
+    return index * cache.width() / visibleSpan;
+}
+
+qint64 TracePlotWidget::firstIndexOf(qint64 column) const {
+    const qint64 width = qMax(1, cache.width());
+    return column <= 0 ? 0 : (column * visibleSpan + width - 1) / width;
+}
+
+size_t TracePlotWidget::ringSize() const {
+    // One screen plus slack for the partly visible column at the left edge
+    return size_t(visibleSpan + visibleSpan / 8 + 64);
+}
+
+void TracePlotWidget::resizeRing(Trace &trace) {
+    std::vector<float> values(ringSize());
+    const qint64 oldSize = qint64(trace.values.size());
+    const qint64 kept = qMin(trace.end - trace.first, qint64(values.size()));
+    for (qint64 i = trace.end - kept; i < trace.end; ++i)
+        values[size_t(i % qint64(values.size()))] = trace.values[size_t(i % oldSize)];
+    trace.values.swap(values);
+    trace.first = trace.end - kept;
+}
+
+void TracePlotWidget::updateCache() {
+    const QSize size = plotRect().size();
+    if (size.isEmpty()) return;
+    if (cache.size() != size) {
+        cache = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        cacheValid = false;
+    }
+
+    // The right edge follows the newest sample, but the first screen starts at 0
+    const int width = cache.width();
+    qint64 end = 0;
+    for (const Trace &trace : traces)
+        end = qMax(end, trace.end);
+    const qint64 endColumn = qMax<qint64>(width, columnOf(qMax<qint64>(0, end - 1)) + 1);
+
+    if (!cacheValid || endColumn < cacheEndColumn || endColumn - cacheEndColumn >= width) {
+        cacheEndColumn = endColumn;
+        cache.fill(Qt::transparent);
+        rasterize(endColumn - width, endColumn);
+        cacheValid = true;
+    } else {
+        // Redraw from the last column drawn before, which may have been incomplete
+        qint64 from = endColumn;
+        for (const Trace &trace : traces) {
+            if (trace.visible && trace.end > trace.drawnEnd)
+                from = qMin(from, columnOf(qMax(trace.first, trace.drawnEnd - 1)));
+        }
+        scrollCache(int(endColumn - cacheEndColumn));
+        cacheEndColumn = endColumn;
+        if (from < endColumn)
+            rasterize(qMax(from, endColumn - width), endColumn);
+    }
+
+    for (Trace &trace : traces)
+        trace.drawnEnd = trace.end;
+}
+
+void TracePlotWidget::scrollCache(int columns) {
+    if (columns <= 0) return;
+    const int width = cache.width();
+    const size_t kept = size_t(width - columns) * sizeof(quint32);
+    for (int y = 0; y < cache.height(); ++y) {
+        uchar *line = cache.scanLine(y);
+        std::memmove(line, line + size_t(columns) * sizeof(quint32), kept);
+        std::memset(line + kept, 0, size_t(columns) * sizeof(quint32));
+    }
+}
+
+void TracePlotWidget::rasterize(qint64 firstColumn, qint64 endColumn) {
+    const int width = cache.width();
+    const int height = cache.height();
+    const qint64 leftColumn = cacheEndColumn - width;
+    const QRect strip(int(firstColumn - leftColumn), 0, int(endColumn - firstColumn), height);
+
+    QPainter painter(&cache);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(strip, Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setClipRect(strip);
+
+    const double scale = (height - 1) / (yMax - yMin);
+    auto yFor = [&](float value) { return (height - 1) - (double(value) - yMin) * scale; };
+
+    for (const Trace &trace : traces) {
+        if (!trace.visible || trace.end == trace.first) continue;
+        const qint64 n = qint64(trace.values.size());
+
+        // Start one column early so the new strip joins what is already drawn
+        polyline.clear();
+        for (qint64 column = firstColumn - 1; column < endColumn; ++column) {
+            const qint64 first = qMax(firstIndexOf(column), trace.first);
+            const qint64 last = qMin(firstIndexOf(column + 1), trace.end);
+            if (first >= last) continue;
+
+            float low = trace.values[size_t(first % n)];
+            float high = low;
+            for (qint64 i = first + 1; i < last; ++i) {
+                const float value = trace.values[size_t(i % n)];
+                low = qMin(low, value);
+                high = qMax(high, value);
+            }
+            const qreal x = qreal(column - leftColumn) + 0.5;
+            polyline.append(QPointF(x, yFor(low)));
+            if (high != low)
+                polyline.append(QPointF(x, yFor(high)));
+        }
+        painter.setPen(QPen(trace.color, 1));
+        painter.drawPolyline(polyline);
+    }
+}
+
+void TracePlotWidget::paintEvent(QPaintEvent *) {
+    TraceScope trace("TracePlotWidget::paint");
+    updateCache();
+
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    const QRect plot = plotRect();
+    if (plot.isEmpty() || cache.isNull()) return;
+
+    const QPen gridPen(QColor(0xe0, 0xe0, 0xe0));
+    const QFontMetrics metrics(font());
+
+    // Y grid and labels
+    const qreal yStep = ChartRenderer::niceStep(yMax - yMin, qMax(2, plot.height() / 50));
+    for (qreal v : ChartRenderer::ticks(yMin, yMax, yStep)) {
+        const int y = plot.bottom() - int((v - yMin) / (yMax - yMin) * (plot.height() - 1));
+        painter.setPen(gridPen);
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(0, y - metrics.height() / 2, LeftMargin - 4, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(v, 'g', 6));
+    }
+
+    // X grid and labels in sample indexes; they move with the data
+    const qint64 leftColumn = cacheEndColumn - cache.width();
+    const qint64 firstIndex = firstIndexOf(leftColumn);
+    const qint64 lastIndex = firstIndexOf(cacheEndColumn);
+    const qreal xStep = ChartRenderer::niceStep(qreal(lastIndex - firstIndex), qMax(2, plot.width() / 100));
+    for (qreal v : ChartRenderer::ticks(qreal(firstIndex), qreal(lastIndex), xStep)) {
+        if (v >= qreal(lastIndex))
+            break;
+        const int x = plot.left() + int(columnOf(qint64(v)) - leftColumn);
+        painter.setPen(gridPen);
+        painter.drawLine(x, plot.top(), x, plot.bottom());
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(x - 50, plot.bottom() + 4, 100, metrics.height()),
+                         Qt::AlignHCenter | Qt::AlignTop, QString::number(qint64(v)));
+    }
+
+    painter.drawImage(plot.topLeft(), cache);
+    painter.setPen(Qt::black);
+    painter.drawRect(plot.adjusted(0, 0, -1, -1));
+}
+
+void TracePlotWidget::resizeEvent(QResizeEvent *event) {
+    cacheValid = false;
+    QWidget::resizeEvent(event);
+}
@@ -0,0 +1,70 @@
+#ifndef TRACEPLOTWIDGET_H
+#define TRACEPLOTWIDGET_H
+
+#include <QColor>
+#include <QImage>
+#include <QPolygonF>
+#include <QWidget>
+#include <vector>
+
+// Raster scope view for high-rate live traces. Each trace keeps its last
+// screen of samples in a contiguous float ring, and the traces are drawn
+// into a cached QImage as one min/max envelope per pixel column. When new
+// samples arrive the cache is shifted left and only the columns that
+// scrolled in (plus the still-open last column) are rasterized, so the
+// cost per frame follows the new data rather than the window size. Pure
+// QPainter on a QImage, so it needs no GPU.
+class TracePlotWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit TracePlotWidget(QWidget *parent = nullptr);
+
+    int addTrace(const QColor &color);
+    void setTraceVisible(int trace, bool visible);
+
+    // Empties a trace; the next sample appended gets index firstIndex
+    void restartTrace(int trace, qint64 firstIndex);
+
+    // Samples across the plot width, and the value range shown
+    void setSpan(qint64 samples);
+    qint64 span() const { return visibleSpan; }
+    void setYRange(double min, double max);
+
+    void append(int trace, float value);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Trace {
+        QColor color;
+        bool visible = true;
+        std::vector<float> values;  // ring of the last values.size() samples
+        qint64 first = 0;           // oldest retained index
+        qint64 end = 0;             // one past the newest index
+        qint64 drawnEnd = 0;        // samples already rasterized into the cache
+    };
+
+    QRect plotRect() const;
+    qint64 columnOf(qint64 index) const;
+    qint64 firstIndexOf(qint64 column) const;
+    size_t ringSize() const;
+    void resizeRing(Trace &trace);
+    void updateCache();
+    void scrollCache(int columns);
+    void rasterize(qint64 firstColumn, qint64 endColumn);
+
+    std::vector<Trace> traces;
+    qint64 visibleSpan = 100;
+    double yMin = 0;
+    double yMax = 1;
+
+    QImage cache;                   // plot area only, transparent where empty
+    qint64 cacheEndColumn = 0;      // absolute column just past the cache's right edge
+    bool cacheValid = false;
+    QPolygonF polyline;             // reused between strips
+};
+
+#endif // TRACEPLOTWIDGET_H
@@ -0,0 +1,215 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Events per thread; older ones are overwritten
+static const size_t RingEvents = 1 << 16;
+
+// Rings of finished threads kept for dumps; beyond this new threads take
+// them over, since exporters and importers start a thread per run
+static const size_t MaxFinishedRings = 8;
+
+namespace {
+
+struct Event {
+    const char *name;
+    qint64 timeNs;
+    qint64 value;       // duration for complete events, the value for counters
+    bool isCounter;
+};
+
+struct ThreadRing {
+    QString threadName;
+    int tid;
+    std::vector<Event> events = std::vector<Event>(RingEvents);
+    std::atomic<quint64> recorded{0};     // written only by the owning thread
+    std::atomic<quint64> clearedAt{0};    // events before this were cleared
+    bool finished = false;                // owning thread has exited; guarded by registryMutex
+
+    void record(const Event &event) {
+        const quint64 n = recorded.load(std::memory_order_relaxed);
+        events[n % RingEvents] = event;
+        recorded.store(n + 1, std::memory_order_release);
+    }
+};
+
+// Rings outlive their threads so a dump still has their events
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadRing>> registry;
+int nextTid = 1;
+thread_local ThreadRing *currentRing = nullptr;
+
+// Marks the thread's ring finished when the thread exits
+struct RingOwner {
+    ThreadRing *ring = nullptr;
+    ~RingOwner() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->finished = true;
+        currentRing = nullptr;
+    }
+};
+thread_local RingOwner ringOwner;
+
+ThreadRing *ringForThread() {
+    if (currentRing)
+        return currentRing;
+
+    QThread *thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (threadName.isEmpty()) {
+        const bool gui = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+        threadName = gui ? QString("GUI") : QString();
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ThreadRing *ring = nullptr;
+    size_t finished = 0;
+    for (const auto &candidate : registry) {
+        if (candidate->finished && ++finished > MaxFinishedRings) {
+            ring = candidate.get();
+            break;
+        }
+    }
+    if (ring) {
+        // Taking over the oldest finished ring drops its events
+        ring->clearedAt.store(ring->recorded.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        ring->finished = false;
+    } else {
+        registry.push_back(std::make_unique<ThreadRing>());
+        ring = registry.back().get();
+    }
+    ring->tid = nextTid++;
+    ring->threadName = threadName.isEmpty() ? QString("Thread %1").arg(ring->tid) : threadName;
+    currentRing = ring;
+    ringOwner.ring = ring;
+    return ring;
+}
+
+QByteArray jsonString(const QString &text) {
+    QString escaped;
+    for (QChar c : text) {
+        if (c == u'"' || c == u'\\')
+            escaped += u'\\';
+        if (c.unicode() < 0x20)
+            escaped += QString("\\u%1").arg(c.unicode(), 4, 16, QChar(u'0'));
+        else
+            escaped += c;
+    }
+    return '"' + escaped.toUtf8() + '"';
+}
+
+} // namespace
+
+namespace Tracing {
+
+std::atomic<bool> enabledFlag{false};
+
+void setEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+void complete(const char *name, qint64 beginNs, qint64 endNs) {
+    ringForThread()->record(Event{name, beginNs, endNs - beginNs, false});
+}
+
+void counter(const char *name, qint64 value) {
+    if (isEnabled())
+        ringForThread()->record(Event{name, steadyClockNs(), value, true});
+}
+
+void clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                  [](const std::unique_ptr<ThreadRing> &ring) { return ring->finished; }),
+                   registry.end());
+    for (const auto &ring : registry)
+        ring->clearedAt.store(ring->recorded.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+bool writeChromeJson(const QString &fileName, QString *errorString) {
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) *errorString = file.errorString();
+        return false;
+    }
+
+    // Timestamps are relative to the oldest event so they stay readable
+    struct Snapshot {
+        const ThreadRing *ring;
+        std::vector<Event> events;
+    };
+    std::vector<Snapshot> snapshots;
+    qint64 origin = std::numeric_limits<qint64>::max();
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto &ring : registry) {
+            const quint64 end = ring->recorded.load(std::memory_order_acquire);
+            const quint64 oldest = end > RingEvents ? end - RingEvents : 0;
+            quint64 begin = qMax(oldest, ring->clearedAt.load(std::memory_order_relaxed));
+            Snapshot snapshot{ring.get(), {}};
+            snapshot.events.reserve(size_t(end - begin));
+            for (quint64 i = begin; i < end; ++i)
+                snapshot.events.push_back(ring->events[i % RingEvents]);
+
+            // The owner kept recording while the slots were copied; event i
+            // is intact only if event i + RingEvents was not being written,
+            // i.e. nothing past it has been published since
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const quint64 now = ring->recorded.load(std::memory_order_relaxed);
+            if (now + 1 > begin + RingEvents) {
+                const quint64 firstIntact = qMin(end, now + 1 - RingEvents);
+                snapshot.events.erase(snapshot.events.begin(),
+                                      snapshot.events.begin() + ptrdiff_t(firstIntact - begin));
+            }
+            for (const Event &event : snapshot.events)
+                origin = qMin(origin, event.timeNs);
+            snapshots.push_back(std::move(snapshot));
+        }
+    }
+
+    QByteArray out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    auto append = [&](const QByteArray &line) {
+        if (!first) out += ",\n";
+        out += line;
+        first = false;
+        if (out.size() > (1 << 20)) {
+            file.write(out);
+            out.clear();
+        }
+    };
+
+    for (const Snapshot &snapshot : snapshots) {
+        const QByteArray tid = QByteArray::number(snapshot.ring->tid);
+        append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + tid
+               + ",\"args\":{\"name\":" + jsonString(snapshot.ring->threadName) + "}}");
+        for (const Event &event : snapshot.events) {
+            const QByteArray ts = QByteArray::number((event.timeNs - origin) / 1000.0, 'f', 3);
+            if (event.isCounter) {
+                append("{\"ph\":\"C\",\"name\":" + jsonString(QString::fromUtf8(event.name))
+                       + ",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + ts
+                       + ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}}");
+            } else {
+                append("{\"ph\":\"X\",\"name\":" + jsonString(QString::fromUtf8(event.name))
+                       + ",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + ts
+                       + ",\"dur\":" + QByteArray::number(event.value / 1000.0, 'f', 3) + "}");
+            }
+        }
+    }
+    out += "\n]}\n";
+    file.write(out);
+
+    if (!file.commit()) {
+        if (errorString) *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace Tracing
@@ -0,0 +1,53 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+#include "samplering.h"
+
+// Scoped timers and counters for the hot paths, dumped as Chrome trace-event
+// JSON (chrome://tracing, Perfetto). Each thread records into its own
+// fixed-size ring without locking; only the first event on a thread takes a
+// lock to register the ring. Rings of finished threads are kept for dumps
+// until clear(), and handed to new threads once too many pile up. While
+// tracing is off a scope costs one relaxed atomic load.
+namespace Tracing {
+
+extern std::atomic<bool> enabledFlag;
+
+inline bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+void setEnabled(bool enabled);
+
+// Names must be string literals (or otherwise outlive the trace)
+void complete(const char *name, qint64 beginNs, qint64 endNs);
+void counter(const char *name, qint64 value);
+
+// Drops everything recorded so far and frees the rings of finished threads
+void clear();
+
+// Writes the events of all threads, oldest first. Events a thread records
+// while this runs may be missing from the dump.
+bool writeChromeJson(const QString &fileName, QString *errorString = nullptr);
+
+} // namespace Tracing
+
+// Records the lifetime of the scope as one event
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : name(Tracing::isEnabled() ? name : nullptr), begin(this->name ? steadyClockNs() : 0) {}
+    ~TraceScope() {
+        if (name) Tracing::complete(name, begin, steadyClockNs());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    qint64 begin;
+};
+
+#endif // TRACING_H